@@ -0,0 +1,182 @@
+#ifndef APPEND_LOG_H
+#define APPEND_LOG_H
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+// Append-only storage split into fixed-size chunks that never move.
+//
+// Writers are serialised by an internal mutex, construct the element in
+// place and only then publish the new length with a release store. Readers
+// never lock: they load the length once (acquire) and may read every
+// element below it, which stays at the same address for the lifetime of
+// the log. A View is such a length taken at one instant: the set of rows
+// it covers is frozen, and later appends cannot extend or move them. Their
+// contents are not frozen. The log only guarantees each element was fully
+// constructed before publication; any field the element type lets callers
+// change afterwards (a Transaction's status, say) needs its own
+// synchronisation.
+//
+// The chunk table and the chunks come from `resource`, so a log can be
+// charged to a subsystem (memory_accounting.h).
+template <typename T, std::size_t ChunkSize = 4096>
+class AppendLog {
+public:
+    static constexpr std::size_t kChunkSize = ChunkSize;
+    static constexpr std::size_t kMaxChunks = std::size_t{1} << 15;
+
+private:
+    std::pmr::memory_resource* resource;
+    std::atomic<T*>* chunks;
+    std::atomic<std::size_t> published;
+    std::mutex writeMutex;
+
+    T* allocateChunk() { return static_cast<T*>(resource->allocate(sizeof(T) * ChunkSize, alignof(T))); }
+
+    void freeChunk(T* chunk) { resource->deallocate(chunk, sizeof(T) * ChunkSize, alignof(T)); }
+
+    T* slot(std::size_t i) const {
+        return chunks[i / ChunkSize].load(std::memory_order_acquire) + (i % ChunkSize);
+    }
+
+public:
+    template <typename Owner, typename Ref>
+    class Iterator {
+    private:
+        Owner* owner;
+        std::size_t pos;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::remove_reference_t<Ref>*;
+        using reference = Ref;
+
+        Iterator() : owner(nullptr), pos(0) {}
+        Iterator(Owner* owner, std::size_t pos) : owner(owner), pos(pos) {}
+
+        reference operator*() const { return (*owner)[pos]; }
+        pointer operator->() const { return &(*owner)[pos]; }
+        reference operator[](difference_type n) const { return (*owner)[pos + static_cast<std::size_t>(n)]; }
+        Iterator& operator++() { ++pos; return *this; }
+        Iterator operator++(int) { Iterator t = *this; ++pos; return t; }
+        Iterator& operator--() { --pos; return *this; }
+        Iterator operator--(int) { Iterator t = *this; --pos; return t; }
+        Iterator& operator+=(difference_type n) { pos += static_cast<std::size_t>(n); return *this; }
+        Iterator& operator-=(difference_type n) { pos -= static_cast<std::size_t>(n); return *this; }
+        Iterator operator+(difference_type n) const { Iterator t = *this; return t += n; }
+        friend Iterator operator+(difference_type n, Iterator it) { return it += n; }
+        Iterator operator-(difference_type n) const { Iterator t = *this; return t -= n; }
+        difference_type operator-(const Iterator& o) const {
+            return static_cast<difference_type>(pos) - static_cast<difference_type>(o.pos);
+        }
+        bool operator==(const Iterator& o) const { return pos == o.pos; }
+        auto operator<=>(const Iterator& o) const { return pos <=> o.pos; }
+    };
+
+    // The prefix of the log published when it was taken; see above for
+    // what that does and does not pin down.
+    class View {
+    private:
+        const AppendLog* log;
+        std::size_t count;
+
+    public:
+        using iterator = Iterator<const View, const T&>;
+
+        View() : log(nullptr), count(0) {}
+        View(const AppendLog* log, std::size_t count) : log(log), count(count) {}
+
+        std::size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        const T& operator[](std::size_t i) const { return *log->slot(i); }
+        const T& back() const { return (*this)[count - 1]; }
+        iterator begin() const { return iterator(this, 0); }
+        iterator end() const { return iterator(this, count); }
+    };
+
+    using iterator = Iterator<AppendLog, T&>;
+    using const_iterator = Iterator<const AppendLog, const T&>;
+
+    explicit AppendLog(std::pmr::memory_resource* resource = std::pmr::new_delete_resource())
+        : resource(resource),
+          chunks(static_cast<std::atomic<T*>*>(
+              resource->allocate(sizeof(std::atomic<T*>) * kMaxChunks, alignof(std::atomic<T*>)))),
+          published(0) {
+        for (std::size_t c = 0; c < kMaxChunks; ++c) new (&chunks[c]) std::atomic<T*>(nullptr);
+    }
+
+    ~AppendLog() {
+        std::size_t n = published.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < n; ++i) slot(i)->~T();
+        for (std::size_t c = 0; c < kMaxChunks; ++c) {
+            if (T* chunk = chunks[c].load(std::memory_order_relaxed)) freeChunk(chunk);
+        }
+        resource->deallocate(chunks, sizeof(std::atomic<T*>) * kMaxChunks, alignof(std::atomic<T*>));
+    }
+
+    AppendLog(const AppendLog&) = delete;
+    AppendLog& operator=(const AppendLog&) = delete;
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        std::size_t n = published.load(std::memory_order_relaxed);
+        std::size_t c = n / ChunkSize;
+        if (c >= kMaxChunks) throw std::length_error("AppendLog capacity exceeded");
+        T* chunk = chunks[c].load(std::memory_order_relaxed);
+        if (!chunk) {
+            chunk = allocateChunk();
+            chunks[c].store(chunk, std::memory_order_release);
+        }
+        T* item = new (chunk + (n % ChunkSize)) T(std::forward<Args>(args)...);
+        published.store(n + 1, std::memory_order_release);
+        return *item;
+    }
+
+    T& push_back(const T& value) { return emplace_back(value); }
+
+    // Appends a batch under a single writer lock and publishes it at once,
+    // so readers see either none or all of it.
+    template <typename InputIt>
+    void append(InputIt first, InputIt last) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        std::size_t n = published.load(std::memory_order_relaxed);
+        for (; first != last; ++first, ++n) {
+            std::size_t c = n / ChunkSize;
+            if (c >= kMaxChunks) throw std::length_error("AppendLog capacity exceeded");
+            T* chunk = chunks[c].load(std::memory_order_relaxed);
+            if (!chunk) {
+                chunk = allocateChunk();
+                chunks[c].store(chunk, std::memory_order_release);
+            }
+            new (chunk + (n % ChunkSize)) T(*first);
+        }
+        published.store(n, std::memory_order_release);
+    }
+
+    std::size_t size() const { return published.load(std::memory_order_acquire); }
+    bool empty() const { return size() == 0; }
+
+    T& operator[](std::size_t i) { return *slot(i); }
+    const T& operator[](std::size_t i) const { return *slot(i); }
+    T& back() { return (*this)[size() - 1]; }
+    const T& back() const { return (*this)[size() - 1]; }
+
+    View snapshot() const { return View(this, size()); }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, size()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+};
+
+#endif // APPEND_LOG_H
@@ -0,0 +1,55 @@
+#include "approx_analytics.h"
+
+using namespace std;
+
+atomic<bool> approximateAnalytics{false};
+AnalyticsSketches analyticsSketches;
+
+int64_t sketchDay(chrono::system_clock::time_point tp) {
+    return chrono::duration_cast<chrono::hours>(tp.time_since_epoch()).count() / 24;
+}
+
+SellerSketch::SellerSketch() {
+    dailyBuyers.fill(SpaceSaving<int>(kBuyersPerDay));
+    bucketDay.fill(-1);
+}
+
+void SellerSketch::add(int buyerId, int64_t day) {
+    distinctBuyers.add(sketchHash(buyerId));
+    size_t slot = static_cast<size_t>(day % kWindowDays);
+    if (day < bucketDay[slot]) {
+        // A newer day already owns the slot, so this record is at least a
+        // full window old; counting it would only pollute that day.
+        return;
+    }
+    if (bucketDay[slot] != day) {
+        // The slot last held a day that has left the window; recycle it.
+        dailyBuyers[slot] = SpaceSaving<int>(kBuyersPerDay);
+        bucketDay[slot] = day;
+    }
+    dailyBuyers[slot].add(buyerId);
+}
+
+SpaceSaving<int> SellerSketch::recentBuyers(int64_t today, int days) const {
+    SpaceSaving<int> merged(kBuyersPerDay * kWindowDays);
+    for (int i = 0; i < kWindowDays; ++i) {
+        if (bucketDay[i] >= 0 && bucketDay[i] > today - days && bucketDay[i] <= today) {
+            merged.merge(dailyBuyers[i]);
+        }
+    }
+    return merged;
+}
+
+void AnalyticsSketches::observe(const Transaction& t) {
+    lock_guard<std::mutex> lock(mutex);
+    const string& item = t.getItemName();
+    itemFrequency.add(sketchHash(item));
+    topItems.add(item);
+
+    buyerFrequency.add(sketchHash(t.getBuyerId()));
+    topBuyers.add(t.getBuyerId());
+    sellerFrequency.add(sketchHash(t.getSellerId()));
+    topSellers.add(t.getSellerId());
+
+    sellers[t.getSellerId()].add(t.getBuyerId(), sketchDay(t.getTimestamp()));
+}
@@ -0,0 +1,58 @@
+#ifndef APPROX_ANALYTICS_H
+#define APPROX_ANALYTICS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "sketches.h"
+#include "transaction.h"
+
+// When set, the frequency reports answer from the sketches below instead of
+// scanning the full transaction history.
+extern std::atomic<bool> approximateAnalytics;
+
+// Per-seller summaries: distinct buyers (all time) and one heavy-hitter
+// summary of buyers per day, so "last month" queries merge at most
+// kWindowDays small buckets.
+struct SellerSketch {
+    static constexpr int kWindowDays = 31;
+    static constexpr std::size_t kBuyersPerDay = 8;
+
+    HyperLogLog distinctBuyers;
+    std::array<SpaceSaving<int>, kWindowDays> dailyBuyers;
+    std::array<int64_t, kWindowDays> bucketDay;
+
+    SellerSketch();
+    // Records older than the day already held by their bucket only count
+    // toward distinctBuyers.
+    void add(int buyerId, int64_t day);
+    // Buyers of the last `days` calendar days (UTC), including today.
+    SpaceSaving<int> recentBuyers(int64_t today, int days) const;
+};
+
+struct AnalyticsSketches {
+    static constexpr std::size_t kHeavyHitters = 64;
+
+    // Held by observe() and by any report reading the sketches.
+    mutable std::mutex mutex;
+
+    CountMinSketch itemFrequency;
+    CountMinSketch buyerFrequency;
+    CountMinSketch sellerFrequency;
+    SpaceSaving<std::string> topItems{kHeavyHitters};
+    SpaceSaving<int> topBuyers{kHeavyHitters};
+    SpaceSaving<int> topSellers{kHeavyHitters};
+    std::unordered_map<int, SellerSketch> sellers;
+
+    void observe(const Transaction& t);
+};
+
+extern AnalyticsSketches analyticsSketches;
+
+int64_t sketchDay(chrono::system_clock::time_point tp);
+
+#endif // APPROX_ANALYTICS_H
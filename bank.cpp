@@ -1,202 +1,281 @@
 #include "bank.h"
-#include "cash_flow_log.h" 
-#include "transaction.h"
-#include "buyer.h" 
+#include "clock.h"
+#include "ledger.h"
+#include "metrics.h"
+#include "trace.h"
+#include "parallel_scan.h"
 #include <algorithm>
 #include <stdexcept>
-#include <map>
-#include <ctime>
 #include <chrono>
-#include <iomanip>
+#include <cmath>
+#include <cstdint>
+#include <functional>
 
 using namespace std;
 
-extern vector<Transaction> allTransactions; 
-extern vector<Buyer> buyers; 
-extern vector<CashFlowLog> cashFlows; 
+namespace {
 
-Bank::Bank(const std::string& name) : name(name), customerCount(0) { }
+std::uint64_t emailKey(std::string_view normalizedEmail) { return std::hash<std::string_view>{}(normalizedEmail); }
+
+} // namespace
+
+Bank::Bank(const std::string& name, std::size_t shardCount) : name(name), customerCount(0) {
+    if (shardCount == 0) shardCount = 1;
+    shards.reserve(shardCount);
+    for (std::size_t i = 0; i < shardCount; ++i) shards.push_back(std::make_unique<BankShard>());
+}
 
 BankCustomer& Bank::createAccount(const std::string& customerName,
                                   double initialDeposit,
                                   const std::string& address,
                                   const std::string& phone,
-                                  const std::string& email) {
-    
-    customerCount++;
-    int newId = customerCount;
-    Accounts.emplace_back(newId, customerName, initialDeposit);
+                                  const std::string& email,
+                                  std::chrono::system_clock::time_point openedAt) {
+    TRACE_SPAN("Bank::createAccount");
+
+    std::string normalizedEmail;
+    std::uint64_t packedPhone = 0;
+    if (!normalizeEmail(email, normalizedEmail)) throw std::runtime_error("invalid email address");
+    if (!packPhone(phone, packedPhone)) throw std::runtime_error("invalid phone number");
+    if (address.size() > UINT16_MAX || normalizedEmail.size() > UINT16_MAX) {
+        throw std::runtime_error("contact details too long");
+    }
     
-    CashFlowLog initialDepositLog(newId, "Credit", initialDeposit, "Initial Deposit");
-    cashFlows.push_back(initialDepositLog);
+    std::unique_lock<std::mutex> lock(accountsMutex);
+    // Only createAccount writes the indexes, so holding accountsMutex is
+    // enough to read them here.
+    if (!normalizedEmail.empty() && findByEmailLocked(normalizedEmail)) {
+        throw std::runtime_error("email already registered");
+    }
+    if (packedPhone != 0 && findByPhoneLocked(packedPhone)) {
+        throw std::runtime_error("phone number already registered");
+    }
+
+    CustomerContact contact;
+    if (!address.empty() || !normalizedEmail.empty() || packedPhone != 0) {
+        std::size_t length = address.size() + normalizedEmail.size();
+        char* text = length ? static_cast<char*>(contactText.allocate(length, 1)) : nullptr;
+        std::copy(address.begin(), address.end(), text);
+        std::copy(normalizedEmail.begin(), normalizedEmail.end(), text + address.size());
+        contact = CustomerContact(text, static_cast<std::uint16_t>(address.size()),
+                                  static_cast<std::uint16_t>(normalizedEmail.size()), packedPhone);
+    }
 
-    std::cout << "Bank: Account created for " << customerName 
-              << " with ID: " << newId << std::endl;
+    int newId = customerCount.load(std::memory_order_relaxed) + 1;
+    BankCustomer& account = shards[shardOf(newId)]->accounts.emplace_back(newId, customerName, initialDeposit, contact);
+    customerCount.store(newId, std::memory_order_release);
+    if (!normalizedEmail.empty() || packedPhone != 0) {
+        std::unique_lock<std::shared_mutex> contacts(contactMutex);
+        if (!normalizedEmail.empty()) emailIndex.insert(emailKey(normalizedEmail), newId);
+        if (packedPhone != 0) phoneIndex.insert(packedPhone, newId);
+    }
+    lock.unlock();
     
-    return Accounts.back(); 
+    CashFlowLog initialDepositLog(newId, "Credit", initialDeposit, "Initial Deposit", openedAt);
+    recordCashFlow(initialDepositLog);
+
+    return account; 
 }
 
 BankCustomer& Bank::findCustomerById(int id) {
-    for (auto &a : Accounts) {
-        if (a.getId() == id) return a;
-    }
+    if (BankCustomer* acct = findCustomerByIdOrNull(id)) return *acct;
     throw std::runtime_error("Error: Bank Customer ID not found.");
 }
 
 BankCustomer* Bank::findCustomerByIdOrNull(int id) {
-    for (auto &a : Accounts) {
-        if (a.getId() == id) return &a;
+    if (id < 1 || id > customerCount.load(std::memory_order_acquire)) return nullptr;
+    return &shards[shardOf(id)]->accounts[slotOf(id)];
+}
+
+BankCustomer* Bank::findByEmailLocked(std::string_view normalizedEmail) {
+    int id = emailIndex.find(emailKey(normalizedEmail), [&](int candidate) {
+        return shards[shardOf(candidate)]->accounts[slotOf(candidate)].getContact().email() == normalizedEmail;
+    });
+    return id ? &shards[shardOf(id)]->accounts[slotOf(id)] : nullptr;
+}
+
+BankCustomer* Bank::findByPhoneLocked(std::uint64_t packedPhone) {
+    // The packed phone is the number itself, so equal keys always match.
+    int id = phoneIndex.find(packedPhone, [](int) { return true; });
+    return id ? &shards[shardOf(id)]->accounts[slotOf(id)] : nullptr;
+}
+
+BankCustomer* Bank::findCustomerByEmail(std::string_view email) {
+    // Reused so a lookup does not allocate.
+    thread_local std::string normalizedEmail;
+    if (!normalizeEmail(email, normalizedEmail) || normalizedEmail.empty()) return nullptr;
+    std::shared_lock<std::shared_mutex> contacts(contactMutex);
+    return findByEmailLocked(normalizedEmail);
+}
+
+BankCustomer* Bank::findCustomerByPhone(std::string_view phone) {
+    std::uint64_t packedPhone = 0;
+    if (!packPhone(phone, packedPhone) || packedPhone == 0) return nullptr;
+    std::shared_lock<std::shared_mutex> contacts(contactMutex);
+    return findByPhoneLocked(packedPhone);
+}
+
+std::vector<const BankCustomer*> Bank::accountsSnapshot() const {
+    int count = customerCount.load(std::memory_order_acquire);
+    std::vector<const BankCustomer*> accounts;
+    accounts.reserve(static_cast<size_t>(count));
+    for (int id = 1; id <= count; ++id) {
+        accounts.push_back(&shards[shardOf(id)]->accounts[slotOf(id)]);
     }
-    return nullptr;
+    return accounts;
 }
 
-bool Bank::deposit(int id, double amount) {
+TransferStatus Bank::deposit(int id, double amount) {
+    MetricTimer timer(Metric::BANK_DEPOSIT);
+    TRACE_SPAN("Bank::deposit");
     BankCustomer* acct = findCustomerByIdOrNull(id);
-    if (!acct) {
-        std::cout << "Bank: Deposit failed: Account not found.\n";
-        return false;
-    }
-    if (amount <= 0) {
-        std::cout << "Bank: Deposit failed: amount must be positive.\n";
-        return false;
-    }
-    acct->addBalance(amount);
-    
+    if (!acct) return TransferStatus::ACCOUNT_NOT_FOUND;
+    if (!(amount > 0)) return TransferStatus::INVALID_AMOUNT;
     CashFlowLog depositLog(id, "Credit", amount, "User Topup/Deposit");
-    cashFlows.push_back(depositLog);
-
-    std::cout << "Bank: Deposit successful. New balance: $" << fixed << setprecision(2) << acct->getBalance() << "\n";
-    return true;
+    std::lock_guard<std::mutex> lock(lockFor(id));
+    acct->addBalance(amount);
+    recordCashFlow(depositLog);
+    return TransferStatus::OK;
 }
 
-bool Bank::withdraw(int id, double amount) {
+TransferStatus Bank::withdraw(int id, double amount) {
+    MetricTimer timer(Metric::BANK_WITHDRAW);
+    TRACE_SPAN("Bank::withdraw");
     BankCustomer* acct = findCustomerByIdOrNull(id);
-    if (!acct) {
-        std::cout << "Bank: Withdraw failed: Account not found.\n";
-        return false;
-    }
-    if (amount <= 0) {
-        std::cout << "Bank: Withdraw failed: amount must be positive.\n";
-        return false;
+    if (!acct) return TransferStatus::ACCOUNT_NOT_FOUND;
+    if (!(amount > 0)) return TransferStatus::INVALID_AMOUNT;
+    bool ok;
+    {
+        std::lock_guard<std::mutex> lock(lockFor(id));
+        ok = acct->withdrawBalance(amount);
+        if (ok) recordCashFlow(CashFlowLog(id, "Debit", amount, "User Withdrawal"));
     }
-    bool ok = acct->withdrawBalance(amount);
-    if (ok) {
-        CashFlowLog withdrawLog(id, "Debit", amount, "User Withdrawal");
-        cashFlows.push_back(withdrawLog);
-        
-        std::cout << "Bank: Withdraw successful. New balance: $" << fixed << setprecision(2) << acct->getBalance() << "\n";
-    } else {
-        std::cout << "Bank: Withdraw failed due to insufficient funds.\n";
+    if (!ok) {
+        countEvent(Counter::WITHDRAW_DECLINED);
+        return TransferStatus::INSUFFICIENT_FUNDS;
     }
-    return ok;
+    return TransferStatus::OK;
 }
 
-void Bank::printCustomerInfo(int id) {
-    BankCustomer* acct = findCustomerByIdOrNull(id);
-    if (!acct) {
-        std::cout << "Bank: Account not found.\n";
-        return;
+TransferStatus Bank::transfer(const std::vector<TransferLeg>& legs) {
+    MetricTimer timer(Metric::BANK_TRANSFER);
+    TRACE_SPAN("Bank::transfer");
+    if (legs.empty()) return TransferStatus::EMPTY;
+
+    double debits = 0.0, credits = 0.0;
+    std::vector<std::pair<BankCustomer*, double>> debitTotals;
+    std::vector<std::size_t> lockOrder;
+    std::vector<BankCustomer*> targets;
+    for (const auto& leg : legs) {
+        BankCustomer* acct = findCustomerByIdOrNull(leg.accountId);
+        if (!acct) return TransferStatus::ACCOUNT_NOT_FOUND;
+        if (!(leg.amount > 0)) return TransferStatus::INVALID_AMOUNT;
+        lockOrder.push_back(lockRank(leg.accountId));
+        targets.push_back(acct);
+
+        if (leg.kind == TransferLeg::DEBIT) {
+            debits += leg.amount;
+            auto it = find_if(debitTotals.begin(), debitTotals.end(),
+                              [&](const auto& d) { return d.first == acct; });
+            if (it == debitTotals.end()) debitTotals.emplace_back(acct, leg.amount);
+            else it->second += leg.amount;
+        } else {
+            credits += leg.amount;
+        }
     }
-    acct->printInfo();
-}
+    // Line totals and per-seller sums round differently; allow for that.
+    if (fabs(debits - credits) > 1e-9 * max(1.0, debits)) return TransferStatus::UNBALANCED;
 
-void Bank::listAllCustomers() const {
-    std::cout << "\n--- LIST OF ALL BANK CUSTOMERS (" << Accounts.size() << ") ---" << std::endl;
-    for (const auto &a : Accounts) {
-        std::cout << "ID " << a.getId() << ": " << a.getName()
-                  << " (Balance: $" << fixed << setprecision(2) << a.getBalance() << ")\n";
+    std::vector<CashFlowLog> entries;
+    entries.reserve(legs.size());
+    for (const auto& leg : legs) {
+        entries.emplace_back(leg.accountId, leg.kind == TransferLeg::DEBIT ? "Debit" : "Credit",
+                             leg.amount, leg.description);
     }
-    std::cout << "---------------------------------------------------" << std::endl;
-}
 
-void Bank::listDormantAccounts() const {
-    auto thirty_days_ago = chrono::system_clock::now() - chrono::hours(24 * 30); 
-    std::vector<const BankCustomer*> dormantList;
-
-    for (const auto& customer : Accounts) {
-        bool hasRecentActivity = false;
-        
-        for (const auto& transaction : allTransactions) {
-            if ((transaction.getBuyerId() == customer.getId() || transaction.getSellerId() == customer.getId()) &&
-                transaction.getTimestamp() >= thirty_days_ago) {
-                hasRecentActivity = true;
-                break;
-            }
-        }
-        
-        if (!hasRecentActivity) {
-            for (const auto& flow : cashFlows) {
-                if (flow.getAccountId() == customer.getId() && flow.getTimestamp() >= thirty_days_ago) {
-                    hasRecentActivity = true;
-                    break;
-                }
-            }
-        }
+    sort(lockOrder.begin(), lockOrder.end());
+    lockOrder.erase(unique(lockOrder.begin(), lockOrder.end()), lockOrder.end());
+    for (std::size_t rank : lockOrder) lockByRank(rank).lock();
 
-        if (!hasRecentActivity) {
-            dormantList.push_back(&customer);
+    // Each account is debited once by the same total the check compared,
+    // so a debit cannot fail on rounding after another leg has applied.
+    bool funded = all_of(debitTotals.begin(), debitTotals.end(),
+                         [](const auto& d) { return d.first->getBalance() >= d.second; });
+    size_t debited = 0;
+    while (funded && debited < debitTotals.size()) {
+        funded = debitTotals[debited].first->withdrawBalance(debitTotals[debited].second);
+        if (funded) ++debited;
+    }
+    if (funded) {
+        for (size_t i = 0; i < legs.size(); ++i) {
+            if (legs[i].kind == TransferLeg::CREDIT) targets[i]->addBalance(legs[i].amount);
         }
+        recordCashFlows(std::move(entries));
+    } else {
+        // Unreachable while every balance change holds its account's lock.
+        for (size_t i = 0; i < debited; ++i) debitTotals[i].first->addBalance(debitTotals[i].second);
     }
 
-    std::cout << "\n--- LIST OF DORMANT ACCOUNTS (" << dormantList.size() << ") ---" << std::endl;
-    if (dormantList.empty()) {
-        std::cout << "No dormant accounts found." << std::endl;
-    } else {
-        for (const auto* customer : dormantList) {
-            std::cout << "ID " << customer->getId() << ": " << customer->getName()
-                      << " (Balance: $" << fixed << setprecision(2) << customer->getBalance() << ")\n";
-        }
+    for (auto it = lockOrder.rbegin(); it != lockOrder.rend(); ++it) lockByRank(*it).unlock();
+    return funded ? TransferStatus::OK : TransferStatus::INSUFFICIENT_FUNDS;
+}
+
+std::vector<AccountSummary> Bank::customers() const {
+    std::vector<AccountSummary> rows;
+    for (const auto* a : accountsSnapshot()) {
+        rows.push_back({a->getId(), a->getName(), a->getBalance()});
     }
-    std::cout << "------------------------------------------" << std::endl;
+    return rows;
 }
 
-void Bank::listTopUsersToday(int n) const {
-    time_t now_t = chrono::system_clock::to_time_t(chrono::system_clock::now());
-    struct tm *ltm = localtime(&now_t);
-    ltm->tm_hour = 0;
-    ltm->tm_min = 0;
-    ltm->tm_sec = 0;
-    auto today_start = chrono::system_clock::from_time_t(mktime(ltm));
+std::vector<AccountSummary> Bank::dormantAccounts() const {
+    auto thirty_days_ago = clockNow() - chrono::hours(24 * 30); 
+    auto accounts = accountsSnapshot();
+    LedgerSnapshot ledger = ledgerSnapshot();
 
-    map<int, int> userActivityCount; 
+    using ActiveSet = TopKAggregator<int>;
+    ActiveSet active = parallelReduce(ledger.transactions, ActiveSet(),
+        [&](ActiveSet& ids, const Transaction& t) {
+            if (t.getTimestamp() >= thirty_days_ago) {
+                ids.add(t.getBuyerId());
+                ids.add(t.getSellerId());
+            }
+        },
+        [](ActiveSet& into, const ActiveSet& from) { into.merge(from); });
+    active.merge(parallelAggregate<int>(ledger.cashFlows,
+        [](const CashFlowLog& flow) { return flow.getAccountId(); },
+        [&](const CashFlowLog& flow) { return flow.getTimestamp() >= thirty_days_ago; }));
 
-    for (const auto& t : allTransactions) {
-        if (t.getTimestamp() >= today_start) {
-            userActivityCount[t.getBuyerId()]++;
-            userActivityCount[t.getSellerId()]++;
-        }
-    }
-    for (const auto& flow : cashFlows) {
-         if (flow.getTimestamp() >= today_start) {
-            userActivityCount[flow.getAccountId()]++;
+    std::vector<AccountSummary> dormantList;
+    for (const auto* customer : accounts) {
+        if (!active.contains(customer->getId())) {
+            dormantList.push_back({customer->getId(), customer->getName(), customer->getBalance()});
         }
     }
+    return dormantList;
+}
 
-    vector<pair<int, int>> sortedUsers; 
-    for (const auto& pair : userActivityCount) {
-        sortedUsers.push_back({pair.second, pair.first}); 
-    }
-    sort(sortedUsers.rbegin(), sortedUsers.rend());
+std::vector<AccountActivity> Bank::topUsersToday(int n) const {
+    if (n <= 0) return {};
+    auto today_start = clockStartOfDay();
 
-    std::cout << "\n--- TOP " << n << " ACTIVE USERS TODAY (By Activity Count) ---" << std::endl;
-    if (sortedUsers.empty()) {
-        std::cout << "No transaction activity found today." << std::endl;
-        return;
-    }
-    for (int i = 0; i < min((int)sortedUsers.size(), n); ++i) {
-        int userId = sortedUsers[i].second;
-        int count = sortedUsers[i].first;
-        
-        string name = "Unknown";
-        for (const auto& b : buyers) {
-            if (b.getId() == userId) {
-                name = b.getName();
-                break;
+    LedgerSnapshot ledger = ledgerSnapshot();
+    using ActivityCount = TopKAggregator<int>;
+    ActivityCount userActivityCount = parallelReduce(ledger.transactions, ActivityCount(),
+        [&](ActivityCount& counts, const Transaction& t) {
+            if (t.getTimestamp() >= today_start) {
+                counts.add(t.getBuyerId());
+                counts.add(t.getSellerId());
             }
-        }
-        
-        std::cout << i + 1 << ". ID " << userId << " (" << name << ") - " 
-                  << count << " activities\n";
+        },
+        [](ActivityCount& into, const ActivityCount& from) { into.merge(from); });
+    userActivityCount.merge(parallelAggregate<int>(ledger.cashFlows,
+        [](const CashFlowLog& flow) { return flow.getAccountId(); },
+        [&](const CashFlowLog& flow) { return flow.getTimestamp() >= today_start; }));
+
+    std::vector<AccountActivity> busiest;
+    for (const auto& entry : userActivityCount.top(static_cast<std::size_t>(n))) {
+        busiest.push_back({entry.second, entry.first});
     }
-    std::cout << "---------------------------------------------------" << std::endl;
+    return busiest;
 }
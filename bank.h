@@ -2,38 +2,161 @@
 #define BANK_H
 
 #include "bank_customer.h"
-#include <iostream>
+#include "append_log.h"
+#include "clock.h"
+#include "contact_index.h"
+#include "memory_accounting.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <shared_mutex>
 #include <vector>
 #include <string>
+#include <string_view>
+
+// One side of a transfer: money leaves (Debit) or enters (Credit) an account.
+struct TransferLeg {
+    enum Kind { DEBIT, CREDIT };
+
+    Kind kind;
+    int accountId;
+    double amount;
+    std::string description;
+};
+
+// OUT_OF_STOCK comes from the payment engine, never from the bank itself.
+enum class TransferStatus { OK, EMPTY, ACCOUNT_NOT_FOUND, INVALID_AMOUNT, UNBALANCED, INSUFFICIENT_FUNDS, OUT_OF_STOCK };
+
+inline const char* transferStatusString(TransferStatus status) {
+    switch (status) {
+        case TransferStatus::OK: return "OK";
+        case TransferStatus::EMPTY: return "no transfer legs";
+        case TransferStatus::ACCOUNT_NOT_FOUND: return "account not found";
+        case TransferStatus::INVALID_AMOUNT: return "amount must be positive";
+        case TransferStatus::UNBALANCED: return "debits and credits do not match";
+        case TransferStatus::INSUFFICIENT_FUNDS: return "insufficient funds";
+        case TransferStatus::OUT_OF_STOCK: return "insufficient stock";
+    }
+    return "UNKNOWN";
+}
+
+// One row of an account listing.
+struct AccountSummary {
+    int id;
+    std::string name;
+    double balance;
+};
+
+// How many ledger entries involved an account (or a buyer/seller id).
+struct AccountActivity {
+    int id;
+    int count;
+};
+
+// One partition of the bank: the accounts whose id maps to it and the
+// locks guarding their balances. Balance updates on different shards never
+// contend for a lock, but every update still queues its cash flows on the
+// one global ledger (ledger.h), so that queue, not the shard count, bounds
+// update throughput once shards outnumber busy threads. bench measures this
+// as bank.shards.N.
+class BankShard {
+public:
+    static constexpr std::size_t kLockStripes = 16;
+
+    struct alignas(64) LockStripe {
+        std::mutex mutex;
+    };
+
+    // Local slot i holds account id i * shardCount + shardIndex + 1.
+    AppendLog<BankCustomer> accounts{memoryResource(MemoryTag::ACCOUNTS)};
+    std::array<LockStripe, kLockStripes> stripes;
+};
 
 class Bank {
 private:
+    static constexpr std::size_t kDefaultShards = 8;
+
     std::string name;
-    std::vector<BankCustomer> Accounts; 
-    int customerCount;
+    // Account id N lives in shard (N - 1) % shardCount, slot (N - 1) / shardCount.
+    std::vector<std::unique_ptr<BankShard>> shards;
+    std::atomic<int> customerCount;
+    // Serialises createAccount so ids are dense and each shard's slots fill in order.
+    std::mutex accountsMutex;
+
+    // Address and email text of every account, appended under accountsMutex.
+    std::pmr::monotonic_buffer_resource contactText{memoryResource(MemoryTag::CONTACTS)};
+    // Normalized email (hashed) and packed phone -> account id. Written
+    // under accountsMutex and contactMutex, read under contactMutex shared.
+    ContactIndex emailIndex{memoryResource(MemoryTag::CONTACTS)};
+    ContactIndex phoneIndex{memoryResource(MemoryTag::CONTACTS)};
+    std::shared_mutex contactMutex;
+
+    BankCustomer* findByEmailLocked(std::string_view normalizedEmail);
+    BankCustomer* findByPhoneLocked(std::uint64_t packedPhone);
+
+    std::size_t shardOf(int id) const { return static_cast<std::size_t>(id - 1) % shards.size(); }
+    std::size_t slotOf(int id) const { return static_cast<std::size_t>(id - 1) / shards.size(); }
+    // Every balance change holds the lock of each account it touches.
+    // Transfers take them in ascending (shard, stripe) order, so they cannot
+    // deadlock with each other or with single-account updates. The change
+    // queues its cash-flow records before unlocking, so an account's ledger
+    // entries follow the order its balance moved. Queueing cannot deadlock
+    // under these locks: the ledger writer never takes them, so a full
+    // queue always drains.
+    std::size_t lockRank(int id) const { return shardOf(id) * BankShard::kLockStripes + slotOf(id) % BankShard::kLockStripes; }
+    std::mutex& lockByRank(std::size_t rank) {
+        return shards[rank / BankShard::kLockStripes]->stripes[rank % BankShard::kLockStripes].mutex;
+    }
+    std::mutex& lockFor(int id) { return lockByRank(lockRank(id)); }
+
+    // Every account in id order, as of the call.
+    std::vector<const BankCustomer*> accountsSnapshot() const;
 
 public:
-    Bank(const std::string& name);
+    Bank(const std::string& name, std::size_t shardCount = kDefaultShards);
 
+    // The bank never writes output; callers render results (reports.h).
+    // `openedAt` dates the initial deposit; only generated history sets it.
+    // Throws std::runtime_error, creating nothing, if the email or phone is
+    // malformed or already belongs to another account (normalizeEmail,
+    // packPhone).
     BankCustomer& createAccount(const std::string& customerName,
                                 double initialDeposit,
                                 const std::string& address = "",
                                 const std::string& phone = "",
-                                const std::string& email = "");
+                                const std::string& email = "",
+                                std::chrono::system_clock::time_point openedAt = clockNow());
 
     BankCustomer& findCustomerById(int id);
     BankCustomer* findCustomerByIdOrNull(int id);
+    // O(1) lookups on the normalized form; null if no account matches or
+    // the input is malformed.
+    BankCustomer* findCustomerByEmail(std::string_view email);
+    BankCustomer* findCustomerByPhone(std::string_view phone);
+
+    // Single-account balance changes: OK, ACCOUNT_NOT_FOUND,
+    // INVALID_AMOUNT, or (withdraw only) INSUFFICIENT_FUNDS.
+    TransferStatus deposit(int id, double amount);
+    TransferStatus withdraw(int id, double amount);
 
-    bool deposit(int id, double amount);
-    bool withdraw(int id, double amount);
+    // Validates every leg, then applies all of them atomically and appends
+    // their cash-flow entries as one ledger batch. Either every leg takes
+    // effect or none does. Legs on one shard only lock that shard.
+    TransferStatus transfer(const std::vector<TransferLeg>& legs);
 
-    void printCustomerInfo(int id);
-    
-    void listAllCustomers() const;
-    void listDormantAccounts() const;
-    void listTopUsersToday(int n) const;
+    // Every account, in id order.
+    std::vector<AccountSummary> customers() const;
+    // Accounts with no transaction or cash flow in the last 30 days.
+    std::vector<AccountSummary> dormantAccounts() const;
+    // The n ids with the most transactions and cash flows since midnight,
+    // busiest first; empty if n <= 0.
+    std::vector<AccountActivity> topUsersToday(int n) const;
 
     int getNextCustomerId() const { return customerCount + 1; }
+    std::size_t getShardCount() const { return shards.size(); }
 };
 
 #endif // BANK_H
@@ -1,9 +1,64 @@
 #include "bank_customer.h"
+#include <cctype>
 #include <iostream>
 #include <iomanip>
 
 using namespace std;
 
+namespace {
+
+constexpr int kPhoneDigitShift = 60;
+constexpr size_t kMaxPhoneDigits = 15;
+
+} // namespace
+
+bool normalizeEmail(string_view email, string& normalized) {
+    normalized.clear();
+    while (!email.empty() && isspace(static_cast<unsigned char>(email.front()))) email.remove_prefix(1);
+    while (!email.empty() && isspace(static_cast<unsigned char>(email.back()))) email.remove_suffix(1);
+    if (email.empty()) return true;
+
+    size_t at = email.find('@');
+    if (at == 0 || at == string_view::npos || at + 1 == email.size() || email.find('@', at + 1) != string_view::npos) {
+        return false;
+    }
+    normalized.assign(email);
+    for (char& c : normalized) {
+        if (c == ' ' || c == '\t') return false;
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    }
+    return true;
+}
+
+bool packPhone(string_view phone, uint64_t& packed) {
+    packed = 0;
+    uint64_t value = 0;
+    uint64_t digits = 0;
+    bool leading = true;
+    for (char c : phone) {
+        if (c >= '0' && c <= '9') {
+            if (++digits > kMaxPhoneDigits) return false;
+            value = value * 10 + static_cast<uint64_t>(c - '0');
+        } else if (c == '+' && leading) {
+            // Country-code prefix; the digits carry the number.
+        } else if (c != ' ' && c != '-' && c != '.' && c != '(' && c != ')') {
+            return false;
+        }
+        if (c != ' ') leading = false;
+    }
+    if (digits == 0) return phone.find_first_not_of(' ') == string_view::npos;
+    packed = digits << kPhoneDigitShift | value;
+    return true;
+}
+
+string unpackPhone(uint64_t packed) {
+    size_t digits = static_cast<size_t>(packed >> kPhoneDigitShift);
+    uint64_t value = packed & ((uint64_t{1} << kPhoneDigitShift) - 1);
+    string phone(digits, '0');
+    for (size_t i = digits; i > 0 && value > 0; --i, value /= 10) phone[i - 1] = static_cast<char>('0' + value % 10);
+    return phone;
+}
+
 string BankCustomer::getName() const {
     return this->name;
 }
@@ -13,7 +68,7 @@ int BankCustomer::getId() const {
 }
 
 double BankCustomer::getBalance() const {
-    return this->balance;
+    return this->balance.load(memory_order_acquire);
 }
 
 void BankCustomer::setName(const string& name) {
@@ -21,23 +76,27 @@ void BankCustomer::setName(const string& name) {
 }
 
 void BankCustomer::setBalance(double amount) {
-    this->balance = amount;
+    this->balance.store(amount, memory_order_release);
 }
 
 void BankCustomer::addBalance(double amount) {
-    this->balance += amount;
+    this->balance.fetch_add(amount, memory_order_acq_rel);
 }
 
 bool BankCustomer::withdrawBalance(double amount){
-    if (amount > this->balance) {
-        return false;
-    }
-    this->balance -= amount;
+    double current = this->balance.load(memory_order_acquire);
+    do {
+        if (amount > current) {
+            return false;
+        }
+    } while (!this->balance.compare_exchange_weak(current, current - amount, memory_order_acq_rel));
     return true;
 }
 
-void BankCustomer::printInfo() const {
-    std::cout << "Customer Name: " << this->name << std::endl;
-    std::cout << "Customer ID: " << this->id << std::endl;
-    std::cout << "Balance: $" << fixed << setprecision(2) << this->balance << std::endl;
+void BankCustomer::printInfo(ostream& out) const {
+    out << "Customer Name: " << this->name << std::endl;
+    out << "Customer ID: " << this->id << std::endl;
+    if (!contact.email().empty()) out << "Email: " << contact.email() << std::endl;
+    if (contact.phoneKey() != 0) out << "Phone: " << contact.phone() << std::endl;
+    out << "Balance: $" << fixed << setprecision(2) << getBalance() << std::endl;
 }
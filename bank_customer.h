@@ -1,37 +1,72 @@
-#ifndef BUYER_H
-#define BUYER_H
+#ifndef BANK_CUSTOMER_H
+#define BANK_CUSTOMER_H
 
-#include <cstddef>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
 #include <string>
-#include <vector>
-#include "bank_customer.h" 
-#include "order.h" 
+#include <string_view>
 
 using namespace std;
 
-class Buyer {
+// Canonical forms used for storage and for the bank's contact indexes.
+// Email: trimmed and lower-cased; needs one '@' with text on both sides.
+// Phone: digits only, after dropping a leading '+' and any spaces, dashes,
+// dots or parentheses; 1 to 15 digits, packed into one integer with the
+// digit count in the top four bits so leading zeros survive. Both return
+// false for malformed input; empty input is valid and yields ""/0.
+bool normalizeEmail(string_view email, string& normalized);
+bool packPhone(string_view phone, uint64_t& packed);
+string unpackPhone(uint64_t packed);
+
+// Address and email point into one block of the bank's contact arena,
+// address first; the phone is packed (packPhone). 24 bytes per customer.
+class CustomerContact {
+private:
+    const char* text = nullptr;
+    uint16_t addressLength = 0;
+    uint16_t emailLength = 0;
+    uint64_t packedPhone = 0;
+
+public:
+    CustomerContact() = default;
+    CustomerContact(const char* text, uint16_t addressLength, uint16_t emailLength, uint64_t packedPhone)
+        : text(text), addressLength(addressLength), emailLength(emailLength), packedPhone(packedPhone) {}
+
+    string_view address() const { return {text, addressLength}; }
+    string_view email() const { return {text ? text + addressLength : nullptr, emailLength}; }
+    uint64_t phoneKey() const { return packedPhone; }
+    string phone() const { return unpackPhone(packedPhone); }
+};
+
+class BankCustomer {
 private:
     int id;
     string name;
-    BankCustomer &account; 
-    vector<Order> orders; 
+    CustomerContact contact;
+    // Updated with atomic read-modify-write so concurrent deposits and
+    // withdrawals never lose an update and readers never see a torn value.
+    atomic<double> balance;
 
 public:
-    Buyer(int id, const string& name, BankCustomer &account0)
-        : id(id), name(name), account(account0) {}
+    BankCustomer(int id, const string& name, double balance, const CustomerContact& contact = {})
+        : id(id), name(name), contact(contact), balance(balance) {}
+
+    BankCustomer(const BankCustomer&) = delete;
+    BankCustomer& operator=(const BankCustomer&) = delete;
 
-    int getId() const { return id; }
-    string getName() const { return name; }
-    BankCustomer& getAccount() { return account; } 
-    vector<Order>& getOrders() { return orders; } 
+    string getName() const;
+    int getId() const;
+    double getBalance() const;
+    const CustomerContact& getContact() const { return contact; }
 
-    void setId(int newId) { id = newId; }
-    void setName(const std::string& newName) { name = newName; }
+    void setName(const string& name);
+    void setBalance(double amount);
+    void addBalance(double amount);
+    // Debits only if the balance covers `amount`; check and debit are one atomic step.
+    bool withdrawBalance(double amount);
 
-    void printInfo() const {
-        std::cout << "Buyer Name: " << name << std::endl;
-        std::cout << "Buyer ID: " << id << std::endl;
-    }
+    void printInfo(ostream& out = cout) const;
 };
 
-#endif // BUYER_H
+#endif // BANK_CUSTOMER_H
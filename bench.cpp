@@ -0,0 +1,515 @@
+// Microbenchmarks for the core library: bank accounts, item lookup, carts,
+// payment settlement and every analytics report, at several data sizes.
+//
+//   bench [--sizes small,medium,large] [--min-time S] [--filter TEXT] [--out FILE]
+//
+// Each size tier adds a generated workload (workload.h) on top of the
+// previous one, then runs every benchmark against the grown store. Results
+// are written one JSON object per line, in a fixed order, so the output of
+// two builds can be diffed or loaded into a spreadsheet:
+//
+//   {"benchmark":"bank.deposit","tier":"small","accounts":1000,"items":1000,
+//    "transactions":21644,"cash_flows":47831,"iterations":51199,"ns_per_op":1020.3}
+//
+// topk.<report>.map_sort and topk.<report>.aggregator rank the same ledger
+// rows each ranking report counts, once the way the reports did before
+// TopKAggregator (a std::map, then every pair sorted) and once with it, both
+// on one thread, so the gain per report is isolated from the parallel scan.
+//
+// Sweeps follow: Bank::transfer against one call per leg, a report scan on
+// pools of 1-8 threads, the column kernels per ISA, and bank shard counts.
+// Lines of cases run with a given thread count carry "threads":N. The
+// bank.shards.N cases (N shards) run once, last, under the largest tier;
+// they use every hardware thread at once, and their ns_per_op is wall time
+// divided by the operations of all threads.
+// Kernel cases also report "rows_per_sec".
+//
+// Progress goes to stderr.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "approx_analytics.h"
+#include "clock.h"
+#include "column_kernels.h"
+#include "ledger.h"
+#include "parallel_scan.h"
+#include "reports.h"
+#include "store.h"
+#include "top_k.h"
+#include "workload.h"
+
+using namespace std;
+
+namespace {
+
+struct Tier {
+    const char* name;
+    WorkloadOptions workload;
+};
+
+// Added cumulatively: "medium" is small + the medium workload, and so on.
+vector<Tier> allTiers() {
+    vector<Tier> tiers(3);
+    tiers[0].name = "small";
+    tiers[0].workload.accounts = 1000;
+    tiers[0].workload.sellers = 20;
+    tiers[0].workload.itemsPerSeller = 50;
+    tiers[0].workload.events = 20000;
+    tiers[1].name = "medium";
+    tiers[1].workload.accounts = 10000;
+    tiers[1].workload.sellers = 100;
+    tiers[1].workload.itemsPerSeller = 200;
+    tiers[1].workload.events = 200000;
+    tiers[2].name = "large";
+    tiers[2].workload.accounts = 100000;
+    tiers[2].workload.sellers = 500;
+    tiers[2].workload.itemsPerSeller = 400;
+    tiers[2].workload.events = 2000000;
+    for (size_t i = 0; i < tiers.size(); ++i) tiers[i].workload.seed = i + 1;
+    return tiers;
+}
+
+// Swallows report text so only the work of producing it is measured.
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+struct Options {
+    vector<string> tiers = {"small", "medium"};
+    double minSeconds = 0.2;
+    string filter;
+    string outPath;
+};
+
+class Runner {
+private:
+    const Options& options;
+    ostream& out;
+    string tier;
+    string sizes;   // JSON fields describing the data the tier started with
+
+public:
+    Runner(const Options& options, ostream& out) : options(options), out(out) {}
+
+    // Benchmarks that deposit or pay add ledger rows as they run; the sizes
+    // reported are the ones generated for the tier, so they stay the same
+    // from build to build.
+    void setTier(const string& name) {
+        tier = name;
+        LedgerSnapshot snapshot = ledgerSnapshot();
+        sizes = ",\"accounts\":" + to_string(myBank.getNextCustomerId() - 1) +
+                ",\"items\":" + to_string(itemIdCounter.load()) +
+                ",\"transactions\":" + to_string(snapshot.transactions.size()) +
+                ",\"cash_flows\":" + to_string(snapshot.cashFlows.size());
+    }
+
+    bool wanted(const string& name) const {
+        if (!options.filter.empty() && name.find(options.filter) == string::npos) return false;
+        cerr << "  " << left << setw(32) << name << flush;
+        return true;
+    }
+
+    // `extra` holds further JSON fields; `rowsPerOp`, if set, adds a scan rate.
+    void report(const string& name, uint64_t iterations, double elapsed, const string& extra = "",
+                uint64_t rowsPerOp = 0) {
+        syncLedger();   // so queued ledger writes are not charged to the next benchmark
+
+        double nanos = elapsed * 1e9 / static_cast<double>(iterations);
+        double rowsPerSecond = static_cast<double>(rowsPerOp) * 1e9 / nanos;
+        cerr << right << setw(14) << fixed << setprecision(1) << nanos << " ns/op";
+        if (rowsPerOp > 0) cerr << setw(10) << setprecision(0) << rowsPerSecond / 1e6 << " M rows/s";
+        cerr << endl;
+
+        out << "{\"benchmark\":\"" << name << "\",\"tier\":\"" << tier << "\"" << sizes << extra
+            << ",\"iterations\":" << iterations
+            << ",\"ns_per_op\":" << fixed << setprecision(1) << nanos;
+        if (rowsPerOp > 0) out << ",\"rows_per_sec\":" << setprecision(0) << rowsPerSecond;
+        out << "}\n";
+    }
+
+    // Calls `op` in growing batches until minSeconds have passed.
+    void run(const string& name, const function<void()>& op, const string& extra = "", uint64_t rowsPerOp = 0) {
+        if (!wanted(name)) return;
+        op();   // warm-up
+
+        uint64_t iterations = 0, batch = 1;
+        double elapsed = 0;
+        auto started = chrono::steady_clock::now();
+        while (elapsed < options.minSeconds) {
+            for (uint64_t i = 0; i < batch; ++i) op();
+            iterations += batch;
+            elapsed = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+            if (elapsed < options.minSeconds / 10) batch *= 2;
+        }
+        report(name, iterations, elapsed, extra, rowsPerOp);
+    }
+
+    // Calls op(thread) on `threads` threads at once until minSeconds have
+    // passed.
+    void runThreads(const string& name, int threads, const function<void(int)>& op) {
+        if (!wanted(name)) return;
+        atomic<bool> stop{false};
+        vector<uint64_t> counts(static_cast<size_t>(threads));
+        vector<thread> workers;
+        auto started = chrono::steady_clock::now();
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                uint64_t n = 0;
+                for (; !stop.load(memory_order_relaxed); ++n) op(t);
+                counts[static_cast<size_t>(t)] = n;
+            });
+        }
+        this_thread::sleep_for(chrono::duration<double>(options.minSeconds));
+        stop = true;
+        for (thread& w : workers) w.join();
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+        uint64_t iterations = 0;
+        for (uint64_t n : counts) iterations += n;
+        report(name, max<uint64_t>(iterations, 1), elapsed, ",\"threads\":" + to_string(threads));
+    }
+};
+
+// Cycles through a fixed set of random keys so the RNG stays out of the
+// measured loop.
+class KeyCycle {
+private:
+    vector<int> keys;
+    size_t next = 0;
+
+public:
+    KeyCycle(int lo, int hi, uint64_t seed) : keys(4096) {
+        mt19937_64 rng(seed);
+        uniform_int_distribution<int> pick(lo, hi);
+        for (int& k : keys) k = pick(rng);
+    }
+    int operator()() { return keys[next++ % keys.size()]; }
+};
+
+// scan(count) calls count(key) once per counted row.
+template <typename Key, typename Scan>
+vector<pair<int, Key>> mapSortTopK(size_t k, const Scan& scan) {
+    map<Key, int> counts;
+    scan([&](const Key& key) { ++counts[key]; });
+    vector<pair<int, Key>> sorted;
+    for (const auto& entry : counts) sorted.emplace_back(entry.second, entry.first);
+    sort(sorted.rbegin(), sorted.rend());
+    if (sorted.size() > k) sorted.resize(k);
+    return sorted;
+}
+
+template <typename Key, typename Scan>
+vector<pair<int, Key>> aggregatorTopK(size_t k, const Scan& scan) {
+    TopKAggregator<Key> counts;
+    scan([&](const Key& key) { counts.add(key); });
+    return counts.top(k);
+}
+
+template <typename Key, typename Scan>
+void compareTopK(Runner& bench, const string& report, size_t k, const Scan& scan) {
+    if (mapSortTopK<Key>(k, scan) != aggregatorTopK<Key>(k, scan)) {
+        cerr << "topk." << report << ": the two rankings differ" << endl;
+        abort();
+    }
+    bench.run("topk." + report + ".map_sort", [&] { mapSortTopK<Key>(k, scan); });
+    bench.run("topk." + report + ".aggregator", [&] { aggregatorTopK<Key>(k, scan); });
+}
+
+// The rankings behind each top-K report, with the report's own k and filter.
+void topKSweep(Runner& bench, int sellerId) {
+    LedgerSnapshot ledger = ledgerSnapshot();
+    auto monthAgo = clockNow() - chrono::hours(24 * 30);
+    auto dayStart = clockStartOfDay();
+    compareTopK<string>(bench, "frequent_items", 10, [&](auto&& count) {
+        for (const Transaction& t : ledger.transactions) count(t.getItemName());
+    });
+    compareTopK<int>(bench, "active_buyers", 5, [&](auto&& count) {
+        for (const Transaction& t : ledger.transactions) count(t.getBuyerId());
+    });
+    compareTopK<int>(bench, "active_sellers", 5, [&](auto&& count) {
+        for (const Transaction& t : ledger.transactions) count(t.getSellerId());
+    });
+    compareTopK<string>(bench, "top_items_month", 5, [&](auto&& count) {
+        for (const Transaction& t : ledger.transactions) {
+            if (t.getTimestamp() >= monthAgo && t.getSellerId() == sellerId) count(t.getItemName());
+        }
+    });
+    compareTopK<int>(bench, "loyal_customers", 5, [&](auto&& count) {
+        for (const Transaction& t : ledger.transactions) {
+            if (t.getTimestamp() >= monthAgo && t.getSellerId() == sellerId) count(t.getBuyerId());
+        }
+    });
+    compareTopK<int>(bench, "top_users_today", 5, [&](auto&& count) {
+        for (const Transaction& t : ledger.transactions) {
+            if (t.getTimestamp() < dayStart) continue;
+            count(t.getBuyerId());
+            count(t.getSellerId());
+        }
+        for (const CashFlowLog& flow : ledger.cashFlows) {
+            if (flow.getTimestamp() >= dayStart) count(flow.getAccountId());
+        }
+    });
+}
+
+// One multi-leg payment (a debit split over `legs` - 1 credits) as a single
+// Bank::transfer and as one withdraw or deposit per leg.
+void transferVsPerLeg(Runner& bench, KeyCycle& accountIds) {
+    for (int legs : {2, 4}) {
+        string suffix = "." + to_string(legs) + "_legs";
+        int credits = legs - 1;
+        bench.run("bank.transfer" + suffix, [&] {
+            vector<TransferLeg> transfer;
+            transfer.push_back({TransferLeg::DEBIT, accountIds(), static_cast<double>(credits), "Bench payment"});
+            for (int i = 0; i < credits; ++i) transfer.push_back({TransferLeg::CREDIT, accountIds(), 1.0, "Bench sale"});
+            myBank.transfer(transfer);
+        });
+        bench.run("bank.per_leg" + suffix, [&] {
+            myBank.withdraw(accountIds(), static_cast<double>(credits));
+            for (int i = 0; i < credits; ++i) myBank.deposit(accountIds(), 1.0);
+        });
+    }
+}
+
+// The same report scan on pools of 1 thread up to one per core, the size
+// of analyticsPool() that the reports themselves use.
+void poolSweep(Runner& bench) {
+    size_t cores = max(1u, thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= cores; ++threads) {
+        ThreadPool pool(threads);
+        bench.run("scan.active_buyers.pool_" + to_string(threads), [&] {
+            parallelTopK<int>(ledgerSnapshot().transactions, 5, [](const Transaction& t) { return t.getBuyerId(); },
+                              KeepAll(), UnitWeight(), pool);
+        }, ",\"threads\":" + to_string(threads));
+    }
+}
+
+// Filtered counts over every cash-flow column block with each kernel ISA
+// the CPU has, on one thread.
+void kernelSweep(Runner& bench, int accountId) {
+    RowFilter filter;
+    filter.id = accountId;
+    filter.flag = kDebitFlag;
+    size_t rows = cashFlowColumns.size();
+    KernelIsa detected = ledgerKernelIsa();
+    for (KernelIsa isa : {KernelIsa::Scalar, KernelIsa::Avx2}) {
+        setLedgerKernelIsa(isa);
+        if (ledgerKernelIsa() != isa) continue;
+        bench.run(string("kernel.filter_count.") + (isa == KernelIsa::Avx2 ? "avx2" : "scalar"), [&] {
+            size_t hits = 0;
+            for (size_t b = 0; b < cashFlowColumns.blockCount(rows); ++b) {
+                hits += filterCount(cashFlowColumns.blockView(b, rows), filter);
+            }
+            if (hits > rows) abort();
+        }, "", rows);
+    }
+    setLedgerKernelIsa(detected);
+}
+
+// Two-leg transfers between random accounts of a fresh bank with `shards`
+// shards, from every hardware thread; shows how far sharding the account
+// locks scales given the shared ledger behind them. The throwaway banks'
+// cash flows go into the one process-wide ledger under ids that clash with
+// myBank's, so this runs once, after every tier's report benchmarks.
+void shardSweep(Runner& bench) {
+    constexpr int kAccounts = 4096;
+    int threads = static_cast<int>(max(2u, thread::hardware_concurrency()));
+    for (size_t shards : {1, 2, 4, 8, 16}) {
+        Bank bank("bench", shards);
+        for (int i = 0; i < kAccounts; ++i) bank.createAccount("shard-bench", 1e9);
+        vector<KeyCycle> accountIds;
+        for (int t = 0; t < threads; ++t) accountIds.emplace_back(1, kAccounts, 100 + static_cast<uint64_t>(t));
+        bench.runThreads("bank.shards." + to_string(shards), threads, [&](int t) {
+            KeyCycle& ids = accountIds[static_cast<size_t>(t)];
+            bank.transfer({{TransferLeg::DEBIT, ids(), 1.0, "Bench transfer"},
+                           {TransferLeg::CREDIT, ids(), 1.0, "Bench transfer"}});
+        });
+    }
+}
+
+// Settles `count` payments of one item each and waits for all of them.
+// Empty shelves are restocked first, so every payment takes the success
+// path rather than an OUT_OF_STOCK refusal.
+void settlePayments(Buyer& buyer, KeyCycle& items, int count) {
+    mutex doneMutex;
+    condition_variable allDone;
+    int remaining = count;
+    for (int i = 0; i < count; ++i) {
+        Order order(++orderIdCounter, buyer.getId());
+        {
+            unique_lock<shared_mutex> lock(inventoryMutex);
+            seller* store;
+            if (Item* item = findItemInStore(items(), store)) {
+                if (item->getQuantity() < 1) item->replenish(1000);
+                order.addItem(item->getId(), item->getName(), item->getPrice(), 1, store->getId());
+            }
+        }
+        paymentEngine().submit(paymentRequestFor(order, buyer), [&](const PaymentResult&) {
+            lock_guard<mutex> lock(doneMutex);
+            if (--remaining == 0) allDone.notify_one();
+        });
+    }
+    unique_lock<mutex> lock(doneMutex);
+    allDone.wait(lock, [&] { return remaining == 0; });
+}
+
+void runBenchmarks(Runner& bench) {
+    NullBuffer nullBuffer;
+    ostream sink(&nullBuffer);
+    int accounts = myBank.getNextCustomerId() - 1;
+    int items = itemIdCounter.load();
+    KeyCycle accountIds(1, accounts, 11), itemIds(1, items, 12);
+
+    Buyer& shopper = *findBuyer(accountIds());
+    seller& store = *findSellerByItem(itemIds());
+    myBank.deposit(shopper.getAccount().getId(), 1e12);
+    syncLedger();
+
+    bench.run("bank.find_account", [&] {
+        BankCustomer* account = myBank.findCustomerByIdOrNull(accountIds());
+        if (!account) abort();
+    });
+    bench.run("bank.deposit", [&] { myBank.deposit(accountIds(), 1.0); });
+    bench.run("bank.withdraw", [&] { myBank.withdraw(accountIds(), 0.5); });
+    transferVsPerLeg(bench, accountIds);
+
+    // Every generated account has an email; sample some to look up.
+    KeyCycle contactIds(1, accounts, 13);
+    vector<string> emails;
+    for (int i = 0; i < 4096; ++i) {
+        string_view email = myBank.findCustomerByIdOrNull(contactIds())->getContact().email();
+        if (!email.empty()) emails.emplace_back(email);
+    }
+    size_t nextEmail = 0;
+    if (!emails.empty()) {
+        bench.run("bank.find_by_email", [&] {
+            if (!myBank.findCustomerByEmail(emails[nextEmail++ % emails.size()])) abort();
+        });
+    }
+    bench.run("store.find_item", [&] {
+        shared_lock<shared_mutex> lock(inventoryMutex);
+        seller* owner;
+        if (!findItemInStore(itemIds(), owner)) abort();
+    });
+    bench.run("order.build_cart", [&] {
+        Order order(0, shopper.getId());
+        shared_lock<shared_mutex> lock(inventoryMutex);
+        for (int line = 0; line < 4; ++line) {
+            seller* owner;
+            Item* item = findItemInStore(itemIds(), owner);
+            order.addItem(item->getId(), item->getName(), item->getPrice(), 1, owner->getId());
+        }
+    });
+    bench.run("payment.settle_256", [&] { settlePayments(shopper, itemIds, 256); });
+
+    for (bool approximate : {false, true}) {
+        approximateAnalytics = approximate;
+        string suffix = approximate ? ".approx" : "";
+        bench.run("report.frequent_items" + suffix, [&] { listMostFrequentItems(10, sink); });
+        bench.run("report.active_buyers" + suffix, [&] { listMostActiveBuyers(sink); });
+        bench.run("report.active_sellers" + suffix, [&] { listMostActiveSellers(sink); });
+        bench.run("report.loyal_customers" + suffix, [&] { discoverLoyalCustomerPerMonth(store, sink); });
+    }
+    approximateAnalytics = false;
+    bench.run("report.top_items_month", [&] { discoverTopItemsPerMonth(store, 5, sink); });
+    bench.run("report.recent_transactions", [&] { listRecentTransactions(7, sink); });
+    bench.run("report.uncompleted", [&] { listUncompletedTransactions(sink); });
+    bench.run("report.spending_30d", [&] { checkSpendingLastKDays(shopper, 30, sink); });
+    bench.run("report.cash_flow_month", [&] { listCashFlowLastMonth(shopper.getAccount(), sink); });
+    bench.run("report.all_customers", [&] { listAllCustomers(sink); });
+    bench.run("report.dormant", [&] { listDormantAccounts(sink); });
+    bench.run("report.top_users_today", [&] { listTopUsersToday(5, sink); });
+    topKSweep(bench, store.getId());
+
+    poolSweep(bench);
+    kernelSweep(bench, shopper.getAccount().getId());
+}
+
+vector<string> split(const string& list) {
+    vector<string> parts;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == string::npos) end = list.size();
+        if (end > start) parts.push_back(list.substr(start, end - start));
+        start = end + 1;
+    }
+    return parts;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string flag = argv[i];
+        if (flag == "--sizes") opt.tiers = split(argv[i + 1]);
+        else if (flag == "--min-time") opt.minSeconds = atof(argv[i + 1]);
+        else if (flag == "--filter") opt.filter = argv[i + 1];
+        else if (flag == "--out") opt.outPath = argv[i + 1];
+        else {
+            cerr << "unknown option " << flag << endl;
+            return 1;
+        }
+    }
+    if (argc % 2 == 0) {
+        cerr << "usage: bench [--sizes small,medium,large] [--min-time S] [--filter TEXT] [--out FILE]" << endl;
+        return 1;
+    }
+
+    vector<Tier> tiers = allTiers();
+    vector<bool> wanted(tiers.size());
+    size_t last = 0;
+    for (const string& name : opt.tiers) {
+        size_t t = 0;
+        while (t < tiers.size() && name != tiers[t].name) ++t;
+        if (t == tiers.size()) {
+            cerr << "unknown size " << name << " (small, medium, large)" << endl;
+            return 1;
+        }
+        wanted[t] = true;
+        last = max(last, t);
+    }
+
+    ofstream file;
+    if (!opt.outPath.empty()) {
+        file.open(opt.outPath);
+        if (!file) {
+            cerr << "cannot write " << opt.outPath << endl;
+            return 1;
+        }
+    }
+    ostream& out = opt.outPath.empty() ? cout : file;
+    Runner runner(opt, out);
+
+    // Tiers are cumulative, so the smaller ones are generated even if skipped.
+    for (size_t t = 0; t <= last; ++t) {
+        WorkloadSummary w = generateWorkload(tiers[t].workload);
+        if (!wanted[t]) continue;
+        cerr << tiers[t].name << ": " << myBank.getNextCustomerId() - 1 << " accounts, " << itemIdCounter.load()
+             << " items, " << ledgerSnapshot().transactions.size() << " transactions (generated in "
+             << fixed << setprecision(2) << w.seconds << " s)" << endl;
+        runner.setTier(tiers[t].name);
+        runBenchmarks(runner);
+    }
+    shardSweep(runner);
+    return 0;
+}
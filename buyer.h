@@ -2,8 +2,14 @@
 #define BUYER_H
 
 #include <cstddef>
+#include <deque>
+#include <memory_resource>
+#include <mutex>
 #include <string>
-#include "bank_customer.h"
+#include <utility>
+#include <vector>
+#include "bank_customer.h" 
+#include "order.h" 
 
 using namespace std;
 
@@ -11,7 +17,13 @@ class Buyer {
 private:
     int id;
     string name;
-    BankCustomer &account; // Association with BankCustomer
+    BankCustomer &account; 
+    // A deque, so an order never moves once added and a session may keep
+    // it across a payment. Any number of sessions can be logged in as one
+    // buyer, so the list and the orders' status are only used under
+    // ordersMutex.
+    pmr::deque<Order> orders{memoryResource(MemoryTag::ORDERS)};
+    mutable mutex ordersMutex;
 
 public:
     Buyer(int id, const string& name, BankCustomer &account0)
@@ -19,10 +31,22 @@ public:
 
     int getId() const { return id; }
     string getName() const { return name; }
-    BankCustomer& getAccount() { return account; }
+    BankCustomer& getAccount() const { return account; } 
+    // Hold getOrdersMutex() while using the list or an order in it.
+    pmr::deque<Order>& getOrders() { return orders; } 
+    mutex& getOrdersMutex() const { return ordersMutex; }
+    Order& addOrder(Order order) {
+        lock_guard<mutex> lock(ordersMutex);
+        return orders.emplace_back(std::move(order));
+    }
 
     void setId(int newId) { id = newId; }
     void setName(const std::string& newName) { name = newName; }
+
+    void printInfo(std::ostream& out = std::cout) const {
+        out << "Buyer Name: " << name << std::endl;
+        out << "Buyer ID: " << id << std::endl;
+    }
 };
 
-#endif // BUYER_H
\ No newline at end of file
+#endif // BUYER_H
@@ -2,36 +2,58 @@
 #define CASH_FLOW_LOG_H
 
 #include <string>
+#include <string_view>
 #include <chrono>
 #include <iostream>
 #include <iomanip>
+#include <memory_resource>
+
+#include "clock.h"
+#include "memory_accounting.h"
+#include "report_writer.h"
 
 using namespace std;
 
+// The text is held in the cash-flow subsystem's memory (memory_accounting.h),
+// copies included.
 class CashFlowLog {
 private:
     int accountId;
-    string type; 
+    pmr::string type; 
     double amount;
-    string description;
+    pmr::string description;
     chrono::system_clock::time_point timestamp;
 
+    static pmr::memory_resource* text() { return memoryResource(MemoryTag::CASH_FLOWS); }
+
 public:
-    CashFlowLog(int id, const string& type, double amount, const string& description) 
-        : accountId(id), type(type), amount(amount), description(description) {
-        timestamp = chrono::system_clock::now();
+    CashFlowLog(int id, string_view type, double amount, string_view description) 
+        : accountId(id), type(type, text()), amount(amount), description(description, text()) {
+        timestamp = clockNow();
     }
 
+    // For entries that happened earlier, e.g. generated history.
+    CashFlowLog(int id, string_view type, double amount, string_view description,
+                chrono::system_clock::time_point timestamp)
+        : accountId(id), type(type, text()), amount(amount), description(description, text()), timestamp(timestamp) {}
+
+    CashFlowLog(const CashFlowLog& other)
+        : accountId(other.accountId), type(other.type, text()), amount(other.amount),
+          description(other.description, text()), timestamp(other.timestamp) {}
+    CashFlowLog(CashFlowLog&&) = default;
+    CashFlowLog& operator=(const CashFlowLog&) = default;
+    CashFlowLog& operator=(CashFlowLog&&) = default;
+
     int getAccountId() const { return accountId; }
-    const string& getType() const { return type; }
+    const pmr::string& getType() const { return type; }
     double getAmount() const { return amount; }
-    const string& getDescription() const { return description; }
+    const pmr::string& getDescription() const { return description; }
     chrono::system_clock::time_point getTimestamp() const { return timestamp; }
 
-    void printInfo() const {
-        time_t tt = chrono::system_clock::to_time_t(timestamp);
-        struct tm * ptm = localtime(&tt);
-        cout << "[" << put_time(ptm, "%Y-%m-%d %H:%M:%S") << "] "
+    void printInfo(ostream& out = cout) const {
+        char stamp[kTimestampLength];
+        formatTimestamp(timestamp, stamp);
+        out << "[" << string_view(stamp, sizeof(stamp)) << "] "
              << getType() << " $" << fixed << setprecision(2) << getAmount() << " - " << getDescription();
     }
 };
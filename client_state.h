@@ -0,0 +1,30 @@
+#ifndef CLIENT_STATE_H
+#define CLIENT_STATE_H
+
+#include <memory_resource>
+#include <vector>
+
+#include "order.h"
+
+class Buyer;
+class seller;
+
+// What the store knows about one client between requests: who is logged
+// in and what is in their cart.
+struct ClientState {
+    bool isLoggedIn = false;
+    Buyer* currentBuyer = nullptr;
+    seller* currentSeller = nullptr;
+    std::pmr::vector<OrderItem> cart;
+
+    explicit ClientState(std::pmr::memory_resource* memory = std::pmr::get_default_resource()) : cart(memory) {}
+
+    void logout() {
+        isLoggedIn = false;
+        currentBuyer = nullptr;
+        currentSeller = nullptr;
+        cart.clear();
+    }
+};
+
+#endif // CLIENT_STATE_H
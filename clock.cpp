@@ -0,0 +1,110 @@
+#include "clock.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <ctime>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+atomic<ClockMode> activeClockMode{ClockMode::SYSTEM};
+atomic<int64_t> publishedClockTicks{0};
+
+namespace {
+
+void publish(ClockTime t) { publishedClockTicks.store(t.time_since_epoch().count(), memory_order_relaxed); }
+
+// Publishes the system time once per tick while the coarse clock is on.
+class Ticker {
+private:
+    mutex lock;
+    condition_variable wake;
+    bool stopping = false;
+    thread worker;
+
+public:
+    ~Ticker() { stop(); }
+
+    void start(chrono::milliseconds tick) {
+        stop();
+        stopping = false;
+        worker = thread([this, tick] {
+            unique_lock<mutex> guard(lock);
+            while (!wake.wait_for(guard, tick, [this] { return stopping; })) publish(chrono::system_clock::now());
+        });
+    }
+
+    void stop() {
+        if (!worker.joinable()) return;
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+};
+
+// Serializes mode changes and simulated steps.
+mutex modeLock;
+Ticker ticker;
+
+} // namespace
+
+void useSystemClock() {
+    lock_guard<mutex> guard(modeLock);
+    ticker.stop();
+    activeClockMode.store(ClockMode::SYSTEM, memory_order_relaxed);
+}
+
+void useCoarseClock(chrono::milliseconds tick) {
+    lock_guard<mutex> guard(modeLock);
+    ticker.stop();
+    publish(chrono::system_clock::now());
+    activeClockMode.store(ClockMode::COARSE, memory_order_relaxed);
+    ticker.start(max(tick, chrono::milliseconds(1)));
+}
+
+void useSimulatedClock(ClockTime start) {
+    lock_guard<mutex> guard(modeLock);
+    ticker.stop();
+    publish(start);
+    activeClockMode.store(ClockMode::SIMULATED, memory_order_relaxed);
+}
+
+bool advanceClock(chrono::system_clock::duration by) {
+    lock_guard<mutex> guard(modeLock);
+    if (activeClockMode.load(memory_order_relaxed) != ClockMode::SIMULATED || by.count() < 0) return false;
+    publishedClockTicks.fetch_add(by.count(), memory_order_relaxed);
+    return true;
+}
+
+ClockMode clockMode() { return activeClockMode.load(memory_order_relaxed); }
+
+const char* clockModeName(ClockMode mode) {
+    switch (mode) {
+        case ClockMode::SYSTEM: return "system";
+        case ClockMode::COARSE: return "coarse";
+        case ClockMode::SIMULATED: return "simulated";
+    }
+    return "unknown";
+}
+
+ClockTime clockStartOfDay() {
+    thread_local ClockTime dayStart{};
+    thread_local ClockTime dayEnd{};
+    ClockTime now = clockNow();
+    if (now >= dayStart && now < dayEnd) return dayStart;
+
+    time_t now_t = chrono::system_clock::to_time_t(now);
+    struct tm ltm;
+    localtime_r(&now_t, &ltm);
+    ltm.tm_hour = 0; ltm.tm_min = 0; ltm.tm_sec = 0;
+    ltm.tm_isdst = -1;
+    dayStart = chrono::system_clock::from_time_t(mktime(&ltm));
+    ltm.tm_mday += 1;
+    ltm.tm_isdst = -1;
+    dayEnd = chrono::system_clock::from_time_t(mktime(&ltm));
+    return dayStart;
+}
@@ -0,0 +1,46 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Wall-clock time for ledger records and report windows.
+//
+//   SYSTEM     system_clock::now() on every read (the default)
+//   COARSE     a background thread publishes the time once per tick and a
+//              read is one atomic load, at most a tick behind. For
+//              high-rate appends that do not need finer stamps.
+//   SIMULATED  time stands still until advanceClock() moves it, so
+//              day- and month-window features can be exercised in seconds.
+//
+// Records stamp themselves with clockNow(), and reports measure their
+// windows from it, so both always agree on what "now" is.
+enum class ClockMode : unsigned char { SYSTEM, COARSE, SIMULATED };
+
+using ClockTime = std::chrono::system_clock::time_point;
+
+void useSystemClock();
+void useCoarseClock(std::chrono::milliseconds tick = std::chrono::milliseconds(1));
+// Starts simulated time at `start`.
+void useSimulatedClock(ClockTime start);
+// Moves simulated time forward. Returns false in the other modes.
+bool advanceClock(std::chrono::system_clock::duration by);
+ClockMode clockMode();
+const char* clockModeName(ClockMode mode);
+
+extern std::atomic<ClockMode> activeClockMode;
+extern std::atomic<std::int64_t> publishedClockTicks;   // system_clock ticks since its epoch
+
+inline ClockTime clockNow() {
+    if (activeClockMode.load(std::memory_order_relaxed) == ClockMode::SYSTEM) {
+        return std::chrono::system_clock::now();
+    }
+    return ClockTime(std::chrono::system_clock::duration(publishedClockTicks.load(std::memory_order_relaxed)));
+}
+
+// Local midnight starting clockNow()'s day. The day's bounds are cached
+// per thread, so this calls localtime only when the day changes.
+ClockTime clockStartOfDay();
+
+#endif // CLOCK_H
@@ -0,0 +1,197 @@
+#include "column_kernels.h"
+
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LEDGER_HAVE_AVX2 1
+#else
+#define LEDGER_HAVE_AVX2 0
+#endif
+
+using namespace std;
+
+namespace {
+
+template <bool ById, bool ByFlag>
+inline bool rowMatches(const ColumnView& c, const RowFilter& f, size_t i) {
+    if (c.timestamps[i] < f.since) return false;
+    if (ById && c.ids[i] != f.id) return false;
+    if (ByFlag && c.flags[i] != f.flag) return false;
+    return true;
+}
+
+// The scalar sum keeps four lane accumulators so both implementations add
+// the same values in the same order and return identical totals.
+template <bool ById, bool ByFlag>
+struct ScalarKernel {
+    static size_t count(const ColumnView& c, const RowFilter& f) {
+        size_t n = 0;
+        for (size_t i = 0; i < c.rows; ++i) n += rowMatches<ById, ByFlag>(c, f, i);
+        return n;
+    }
+
+    static double sum(const ColumnView& c, const RowFilter& f) {
+        double lane[4] = {0.0, 0.0, 0.0, 0.0};
+        size_t i = 0;
+        for (; i + 4 <= c.rows; i += 4) {
+            for (size_t l = 0; l < 4; ++l) {
+                if (rowMatches<ById, ByFlag>(c, f, i + l)) lane[l] += c.amounts[i + l];
+            }
+        }
+        double total = (lane[0] + lane[1]) + (lane[2] + lane[3]);
+        for (; i < c.rows; ++i) {
+            if (rowMatches<ById, ByFlag>(c, f, i)) total += c.amounts[i];
+        }
+        return total;
+    }
+
+    static void select(const ColumnView& c, const RowFilter& f, vector<size_t>& out) {
+        for (size_t i = 0; i < c.rows; ++i) {
+            if (rowMatches<ById, ByFlag>(c, f, i)) out.push_back(i);
+        }
+    }
+};
+
+#if LEDGER_HAVE_AVX2
+
+// Processes four rows per step: every column is widened to 64-bit lanes so
+// one mask covers timestamp, id and flag comparisons.
+template <bool ById, bool ByFlag>
+struct Avx2Kernel {
+    __attribute__((target("avx2")))
+    static inline __m256i mask4(const ColumnView& c, size_t i, __m256i sinceMinusOne, __m256i id, __m256i flag) {
+        __m256i ts = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c.timestamps + i));
+        __m256i m = _mm256_cmpgt_epi64(ts, sinceMinusOne);
+        if (ById) {
+            __m128i ids = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c.ids + i));
+            m = _mm256_and_si256(m, _mm256_cmpeq_epi64(_mm256_cvtepi32_epi64(ids), id));
+        }
+        if (ByFlag) {
+            int32_t packed;
+            memcpy(&packed, c.flags + i, sizeof(packed));
+            __m256i flags = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(packed));
+            m = _mm256_and_si256(m, _mm256_cmpeq_epi64(flags, flag));
+        }
+        return m;
+    }
+
+    __attribute__((target("avx2")))
+    static inline void broadcast(const RowFilter& f, __m256i& sinceMinusOne, __m256i& id, __m256i& flag) {
+        // ts >= since  <=>  ts > since - 1, except when since is already the minimum.
+        int64_t bound = f.since == numeric_limits<int64_t>::min() ? f.since : f.since - 1;
+        sinceMinusOne = _mm256_set1_epi64x(bound);
+        id = _mm256_set1_epi64x(f.id);
+        flag = _mm256_set1_epi64x(f.flag);
+    }
+
+    __attribute__((target("avx2")))
+    static size_t count(const ColumnView& c, const RowFilter& f) {
+        __m256i since, id, flag;
+        broadcast(f, since, id, flag);
+        size_t n = 0;
+        size_t i = 0;
+        for (; i + 4 <= c.rows; i += 4) {
+            int bits = _mm256_movemask_pd(_mm256_castsi256_pd(mask4(c, i, since, id, flag)));
+            n += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(bits)));
+        }
+        for (; i < c.rows; ++i) n += rowMatches<ById, ByFlag>(c, f, i);
+        return n;
+    }
+
+    __attribute__((target("avx2")))
+    static double sum(const ColumnView& c, const RowFilter& f) {
+        __m256i since, id, flag;
+        broadcast(f, since, id, flag);
+        __m256d acc = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= c.rows; i += 4) {
+            __m256d amounts = _mm256_loadu_pd(c.amounts + i);
+            acc = _mm256_add_pd(acc, _mm256_and_pd(amounts, _mm256_castsi256_pd(mask4(c, i, since, id, flag))));
+        }
+        double lane[4];
+        _mm256_storeu_pd(lane, acc);
+        double total = (lane[0] + lane[1]) + (lane[2] + lane[3]);
+        for (; i < c.rows; ++i) {
+            if (rowMatches<ById, ByFlag>(c, f, i)) total += c.amounts[i];
+        }
+        return total;
+    }
+
+    __attribute__((target("avx2")))
+    static void select(const ColumnView& c, const RowFilter& f, vector<size_t>& out) {
+        __m256i since, id, flag;
+        broadcast(f, since, id, flag);
+        size_t i = 0;
+        for (; i + 4 <= c.rows; i += 4) {
+            unsigned bits = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(mask4(c, i, since, id, flag))));
+            while (bits) {
+                out.push_back(i + static_cast<size_t>(__builtin_ctz(bits)));
+                bits &= bits - 1;
+            }
+        }
+        for (; i < c.rows; ++i) {
+            if (rowMatches<ById, ByFlag>(c, f, i)) out.push_back(i);
+        }
+    }
+};
+
+bool cpuHasAvx2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+bool cpuHasAvx2() { return false; }
+
+#endif // LEDGER_HAVE_AVX2
+
+KernelIsa detectIsa() {
+    return cpuHasAvx2() ? KernelIsa::Avx2 : KernelIsa::Scalar;
+}
+
+atomic<KernelIsa> activeIsa{detectIsa()};
+
+// Instantiates the kernel matching which optional filters are in use.
+template <template <bool, bool> class Kernel, typename Op>
+auto dispatchFilters(const RowFilter& f, Op op) {
+    bool byId = f.id != RowFilter::kAnyId;
+    bool byFlag = f.flag != RowFilter::kAnyFlag;
+    if (byId && byFlag) return op(Kernel<true, true>());
+    if (byId) return op(Kernel<true, false>());
+    if (byFlag) return op(Kernel<false, true>());
+    return op(Kernel<false, false>());
+}
+
+template <typename Op>
+auto dispatch(const RowFilter& f, Op op) {
+#if LEDGER_HAVE_AVX2
+    if (activeIsa.load(memory_order_relaxed) == KernelIsa::Avx2) return dispatchFilters<Avx2Kernel>(f, op);
+#endif
+    return dispatchFilters<ScalarKernel>(f, op);
+}
+
+} // namespace
+
+KernelIsa ledgerKernelIsa() {
+    return activeIsa.load(memory_order_relaxed);
+}
+
+void setLedgerKernelIsa(KernelIsa isa) {
+    if (isa == KernelIsa::Avx2 && !cpuHasAvx2()) isa = KernelIsa::Scalar;
+    activeIsa.store(isa, memory_order_relaxed);
+}
+
+size_t filterCount(const ColumnView& cols, const RowFilter& filter) {
+    return dispatch(filter, [&](auto kernel) { return kernel.count(cols, filter); });
+}
+
+double filterSum(const ColumnView& cols, const RowFilter& filter) {
+    return dispatch(filter, [&](auto kernel) { return kernel.sum(cols, filter); });
+}
+
+void filterSelect(const ColumnView& cols, const RowFilter& filter, vector<size_t>& out) {
+    dispatch(filter, [&](auto kernel) { kernel.select(cols, filter, out); });
+}
@@ -0,0 +1,52 @@
+#ifndef COLUMN_KERNELS_H
+#define COLUMN_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Read-only view over parallel ledger columns. `ids`, `flags` and `amounts`
+// may be null when no filter or sum needs them.
+struct ColumnView {
+    const int64_t* timestamps = nullptr;
+    const int32_t* ids = nullptr;
+    const uint8_t* flags = nullptr;
+    const double* amounts = nullptr;
+    size_t rows = 0;
+
+    ColumnView slice(size_t begin, size_t end) const {
+        ColumnView v = *this;
+        v.timestamps = timestamps ? timestamps + begin : nullptr;
+        v.ids = ids ? ids + begin : nullptr;
+        v.flags = flags ? flags + begin : nullptr;
+        v.amounts = amounts ? amounts + begin : nullptr;
+        v.rows = end - begin;
+        return v;
+    }
+};
+
+// Row predicate: timestamp >= since, and optionally id == id, flag == flag.
+struct RowFilter {
+    static constexpr int32_t kAnyId = -1;
+    static constexpr int kAnyFlag = -1;
+
+    int64_t since = std::numeric_limits<int64_t>::min();
+    int32_t id = kAnyId;
+    int flag = kAnyFlag;
+};
+
+enum class KernelIsa { Scalar, Avx2 };
+
+// Best instruction set the CPU supports, picked once at startup.
+KernelIsa ledgerKernelIsa();
+// Forces a kernel implementation (e.g. scalar for comparisons). Requests
+// for an unsupported ISA fall back to scalar.
+void setLedgerKernelIsa(KernelIsa isa);
+
+size_t filterCount(const ColumnView& cols, const RowFilter& filter);
+double filterSum(const ColumnView& cols, const RowFilter& filter);
+// Appends the indices (relative to `cols`) of matching rows to `out`.
+void filterSelect(const ColumnView& cols, const RowFilter& filter, std::vector<size_t>& out);
+
+#endif // COLUMN_KERNELS_H
@@ -0,0 +1,30 @@
+#include "contact_index.h"
+
+using namespace std;
+
+void ContactIndex::grow() {
+    pmr::vector<uint64_t> oldKeys(keys.get_allocator());
+    pmr::vector<int> oldIds(ids.get_allocator());
+    oldKeys.swap(keys);
+    oldIds.swap(ids);
+
+    size_t capacity = oldIds.empty() ? 1024 : oldIds.size() * 2;
+    keys.assign(capacity, 0);
+    ids.assign(capacity, 0);
+    for (size_t i = 0; i < oldIds.size(); ++i) {
+        if (oldIds[i] == 0) continue;
+        size_t slot = home(oldKeys[i]);
+        while (ids[slot] != 0) slot = (slot + 1) & (capacity - 1);
+        keys[slot] = oldKeys[i];
+        ids[slot] = oldIds[i];
+    }
+}
+
+void ContactIndex::insert(uint64_t key, int id) {
+    if ((used + 1) * 10 > ids.size() * 7) grow();
+    size_t slot = home(key);
+    while (ids[slot] != 0) slot = (slot + 1) & (ids.size() - 1);
+    keys[slot] = key;
+    ids[slot] = id;
+    ++used;
+}
@@ -0,0 +1,48 @@
+#ifndef CONTACT_INDEX_H
+#define CONTACT_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+// Hash index from a 64-bit key to account ids, for lookups by contact
+// details (Bank::findCustomerByEmail/Phone).
+//
+// Open addressing with linear probing over two flat arrays, 12 bytes a
+// slot, kept at most 70% full; no per-entry allocation, so it stays
+// compact at tens of millions of customers. A key may be a hash of the
+// real value, so find() asks the caller to confirm each candidate. Not
+// synchronised: the owner guards it.
+class ContactIndex {
+private:
+    std::pmr::vector<std::uint64_t> keys;
+    std::pmr::vector<int> ids;   // 0 marks an empty slot
+    std::size_t used = 0;
+
+    std::size_t home(std::uint64_t key) const {
+        // Fibonacci hashing spreads keys that differ only in low bits.
+        return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (ids.size() - 1);
+    }
+    void grow();
+
+public:
+    explicit ContactIndex(std::pmr::memory_resource* resource) : keys(resource), ids(resource) {}
+
+    // `id` must be positive. Keys may repeat.
+    void insert(std::uint64_t key, int id);
+
+    // The first id stored under `key` for which matches(id) holds, or 0.
+    template <typename Match>
+    int find(std::uint64_t key, Match&& matches) const {
+        if (ids.empty()) return 0;
+        for (std::size_t i = home(key);; i = (i + 1) & (ids.size() - 1)) {
+            if (ids[i] == 0) return 0;
+            if (keys[i] == key && matches(ids[i])) return ids[i];
+        }
+    }
+
+    std::size_t size() const { return used; }
+};
+
+#endif // CONTACT_INDEX_H
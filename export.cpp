@@ -0,0 +1,169 @@
+#include "export.h"
+
+#include <algorithm>
+#include <charconv>
+#include <ctime>
+#include <vector>
+
+#include "ledger.h"
+#include "report_writer.h"
+
+using namespace std;
+
+namespace {
+
+using Money = ReportWriter::Money;
+using Stamp = ReportWriter::Timestamp;
+using Format = ExportOptions::Format;
+
+void writeCsvText(ReportWriter& w, string_view text) {
+    if (text.find_first_of(",\"\r\n") == string_view::npos) {
+        w << text;
+        return;
+    }
+    w << '"';
+    for (size_t quote; (quote = text.find('"')) != string_view::npos;) {
+        w << text.substr(0, quote + 1) << '"';
+        text.remove_prefix(quote + 1);
+    }
+    w << text << '"';
+}
+
+void writeJsonText(ReportWriter& w, string_view text) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    w << '"';
+    size_t clean = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        w << text.substr(clean, i - clean);
+        switch (c) {
+            case '"': w << "\\\""; break;
+            case '\\': w << "\\\\"; break;
+            case '\n': w << "\\n"; break;
+            case '\r': w << "\\r"; break;
+            case '\t': w << "\\t"; break;
+            default: w << "\\u00" << kHex[c >> 4] << kHex[c & 0xF]; break;
+        }
+        clean = i + 1;
+    }
+    w << text.substr(clean) << '"';
+}
+
+void writeTransaction(ReportWriter& w, Format format, const Transaction& t) {
+    if (format == Format::CSV) {
+        w << t.getId() << ',' << Stamp{t.getTimestamp()} << ',' << t.getBuyerId() << ',' << t.getSellerId() << ',';
+        writeCsvText(w, t.getItemName());
+        w << ',' << Money{t.getAmount()} << ',' << t.getStatusString();
+    } else {
+        w << "{\"id\":" << t.getId() << ",\"time\":\"" << Stamp{t.getTimestamp()} << "\",\"buyer\":" << t.getBuyerId()
+          << ",\"seller\":" << t.getSellerId() << ",\"item\":";
+        writeJsonText(w, t.getItemName());
+        w << ",\"amount\":" << Money{t.getAmount()} << ",\"status\":\"" << t.getStatusString() << "\"}";
+    }
+    w.endRow();
+}
+
+void writeCashFlow(ReportWriter& w, Format format, const CashFlowLog& f) {
+    if (format == Format::CSV) {
+        w << Stamp{f.getTimestamp()} << ',' << f.getAccountId() << ',';
+        writeCsvText(w, f.getType());
+        w << ',' << Money{f.getAmount()} << ',';
+        writeCsvText(w, f.getDescription());
+    } else {
+        w << "{\"time\":\"" << Stamp{f.getTimestamp()} << "\",\"account\":" << f.getAccountId() << ",\"type\":";
+        writeJsonText(w, f.getType());
+        w << ",\"amount\":" << Money{f.getAmount()} << ",\"description\":";
+        writeJsonText(w, f.getDescription());
+        w << '}';
+    }
+    w.endRow();
+}
+
+// Walks the column blocks of `columns`, limited to the first `logRows`
+// rows, and calls emit(row) for each row that passes `filter` and falls
+// before `until`. Only one block of hits is held at a time.
+template <typename Emit>
+size_t scanBlocks(const LedgerColumns& columns, size_t logRows, const RowFilter& filter, int64_t until, Emit emit) {
+    size_t rows = min(columns.size(), logRows);
+    vector<size_t> hits;
+    hits.reserve(ColumnBlock::kRows);
+    size_t written = 0;
+    for (size_t b = 0; b < columns.blockCount(rows); ++b) {
+        ColumnView view = columns.blockView(b, rows);
+        hits.clear();
+        filterSelect(view, filter, hits);
+        for (size_t i : hits) {
+            if (view.timestamps[i] >= until) continue;
+            if (emit(b * ColumnBlock::kRows + i)) ++written;
+        }
+    }
+    return written;
+}
+
+} // namespace
+
+size_t exportLedger(const ExportOptions& options, ostream& out) {
+    LedgerSnapshot snapshot = ledgerSnapshot();
+    int64_t until = toLedgerTime(options.until);
+    RowFilter filter;
+    filter.since = toLedgerTime(options.since);
+
+    ReportWriter w(out);
+    if (options.table == ExportOptions::Table::TRANSACTIONS) {
+        if (options.format == Format::CSV) {
+            w << "id,time,buyer,seller,item,amount,status\n";
+        }
+        // The transaction columns hold the seller id.
+        filter.id = options.seller;
+        return scanBlocks(transactionColumns, snapshot.transactions.size(), filter, until, [&](size_t row) {
+            const Transaction& t = snapshot.transactions[row];
+            if (options.account != ExportOptions::kAny && t.getBuyerId() != options.account) return false;
+            writeTransaction(w, options.format, t);
+            return true;
+        });
+    }
+
+    if (options.format == Format::CSV) {
+        w << "time,account,type,amount,description\n";
+    }
+    filter.id = options.account;
+    return scanBlocks(cashFlowColumns, snapshot.cashFlows.size(), filter, until, [&](size_t row) {
+        writeCashFlow(w, options.format, snapshot.cashFlows[row]);
+        return true;
+    });
+}
+
+bool parseExportTime(string_view text, chrono::system_clock::time_point& when) {
+    // system_clock counts finer than seconds, so it spans fewer seconds
+    // than a long long holds; convert only what it can represent.
+    auto fromSeconds = [&when](long long seconds) {
+        using Seconds = chrono::duration<long long>;
+        constexpr auto lowest = chrono::duration_cast<Seconds>(chrono::system_clock::duration::min()).count();
+        constexpr auto highest = chrono::duration_cast<Seconds>(chrono::system_clock::duration::max()).count();
+        if (seconds < lowest || seconds > highest) return false;
+        when = chrono::system_clock::time_point(chrono::duration_cast<chrono::system_clock::duration>(Seconds(seconds)));
+        return true;
+    };
+    auto number = [](string_view digits, auto& value) {
+        auto [ptr, ec] = from_chars(digits.data(), digits.data() + digits.size(), value);
+        return !digits.empty() && ec == errc() && ptr == digits.data() + digits.size();
+    };
+
+    if (text.size() == 10 && text[4] == '-' && text[7] == '-') {
+        struct tm local = {};
+        if (!number(text.substr(0, 4), local.tm_year) || !number(text.substr(5, 2), local.tm_mon) ||
+            !number(text.substr(8, 2), local.tm_mday)) {
+            return false;
+        }
+        local.tm_year -= 1900;
+        local.tm_mon -= 1;
+        local.tm_isdst = -1;
+        time_t tt = mktime(&local);
+        if (tt == static_cast<time_t>(-1)) return false;
+        return fromSeconds(static_cast<long long>(tt));
+    }
+
+    long long seconds = 0;
+    return number(text, seconds) && fromSeconds(seconds);
+}
@@ -0,0 +1,48 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <ostream>
+#include <string_view>
+
+// Machine-readable extracts of the ledger for finance.
+//
+// The exporter streams a snapshot of the log: it filters one column block
+// at a time and formats each matching row straight into a ReportWriter
+// buffer. Memory use is therefore the same for any history size, and the
+// output reaches the stream in large chunks.
+//
+// CSV has a header line and quotes fields only when they need it. NDJSON
+// writes one object per line with the same field names. Timestamps are
+// local time ("YYYY-MM-DD HH:MM:SS"), and amounts have two decimals.
+//
+//   transactions: id,time,buyer,seller,item,amount,status
+//   cash flows:   time,account,type,amount,description
+struct ExportOptions {
+    enum class Table { TRANSACTIONS, CASH_FLOWS };
+    enum class Format { CSV, NDJSON };
+
+    static constexpr int kAny = -1;
+
+    Table table = Table::TRANSACTIONS;
+    Format format = Format::CSV;
+    // Rows with since <= time < until.
+    std::chrono::system_clock::time_point since = std::chrono::system_clock::time_point::min();
+    std::chrono::system_clock::time_point until = std::chrono::system_clock::time_point::max();
+    // The buyer of a transaction, or the account of a cash flow.
+    int account = kAny;
+    // Transactions only; cash flows carry no seller.
+    int seller = kAny;
+};
+
+// Writes the header (CSV) and every matching row to `out`; returns the
+// number of rows written.
+std::size_t exportLedger(const ExportOptions& options, std::ostream& out);
+
+// Accepts "YYYY-MM-DD" (local midnight) or whole seconds since the epoch;
+// false for text it cannot parse and times system_clock cannot represent.
+bool parseExportTime(std::string_view text, std::chrono::system_clock::time_point& when);
+
+#endif // EXPORT_H
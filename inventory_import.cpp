@@ -0,0 +1,258 @@
+#include "inventory_import.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#include "store.h"
+
+using namespace std;
+
+namespace {
+
+constexpr size_t kChunkSize = 1 << 20;
+constexpr size_t kBatchRows = 1 << 14;
+// Guards against a corrupt length making the reader buffer grow unbounded.
+constexpr size_t kMaxNameLength = 1 << 16;
+
+// Sliding window over the stream: consume() what has been parsed, and
+// fill() moves the rest to the front and reads more after it.
+class ChunkReader {
+private:
+    istream& in;
+    vector<char> buffer;
+    size_t begin = 0;
+    size_t end = 0;
+    bool eof = false;
+
+public:
+    explicit ChunkReader(istream& in) : in(in), buffer(kChunkSize) {}
+
+    string_view data() const { return string_view(buffer.data() + begin, end - begin); }
+    void consume(size_t n) { begin += n; }
+
+    // Returns false once the stream has no more bytes.
+    bool fill() {
+        if (eof) return false;
+        if (begin > 0) {
+            memmove(buffer.data(), buffer.data() + begin, end - begin);
+            end -= begin;
+            begin = 0;
+        }
+        // A record longer than the buffer: make room for it.
+        if (end == buffer.size()) buffer.resize(buffer.size() * 2);
+        in.read(buffer.data() + end, static_cast<streamsize>(buffer.size() - end));
+        size_t got = static_cast<size_t>(in.gcount());
+        end += got;
+        if (got == 0 || !in) eof = true;
+        return got > 0;
+    }
+};
+
+class Importer {
+private:
+    seller& store;
+    ImportResult& result;
+    vector<Item> batch;
+    size_t row = 0;
+
+public:
+    Importer(seller& store, ImportResult& result) : store(store), result(result) {
+        batch.reserve(kBatchRows);
+    }
+
+    void add(string_view name, int quantity, double price, bool visible) {
+        ++row;
+        if (name.empty() || quantity < 0 || !(price > 0)) {
+            if (result.rejected++ == 0) result.firstRejectedRow = row;
+            return;
+        }
+        Item& item = batch.emplace_back(0, string(name), quantity, price);
+        item.setDisplay(visible);
+        if (batch.size() == kBatchRows) commit();
+    }
+
+    void reject() {
+        ++row;
+        if (result.rejected++ == 0) result.firstRejectedRow = row;
+    }
+
+    void commit() {
+        if (batch.empty()) return;
+        int count = static_cast<int>(batch.size());
+        int first = itemIdCounter.fetch_add(count) + 1;
+        for (int i = 0; i < count; ++i) batch[static_cast<size_t>(i)].setId(first + i);
+
+        unique_lock<shared_mutex> lock(inventoryMutex);
+        store.addItems(batch);
+        indexStoreItems(store, first, count);
+        lock.unlock();
+
+        if (result.firstId == 0) result.firstId = first;
+        result.lastId = first + count - 1;
+        result.imported += static_cast<size_t>(count);
+    }
+};
+
+template <typename T>
+bool parseNumber(string_view text, T& value) {
+    while (!text.empty() && text.front() == ' ') text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\r')) text.remove_suffix(1);
+    auto [ptr, ec] = from_chars(text.data(), text.data() + text.size(), value);
+    return !text.empty() && ec == errc() && ptr == text.data() + text.size();
+}
+
+bool parseVisible(string_view text, bool& visible) {
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\r')) text.remove_suffix(1);
+    while (!text.empty() && text.front() == ' ') text.remove_prefix(1);
+    if (text.empty() || text == "1" || text == "true") visible = true;
+    else if (text == "0" || text == "false") visible = false;
+    else return false;
+    return true;
+}
+
+// One CSV line, without its newline. A quoted name is unescaped into
+// `scratch`; otherwise the name points into the line.
+bool parseCsvLine(string_view line, string& scratch, string_view& name, int& quantity, double& price, bool& visible) {
+    size_t pos;
+    if (!line.empty() && line.front() == '"') {
+        scratch.clear();
+        size_t i = 1;
+        for (;;) {
+            size_t quote = line.find('"', i);
+            if (quote == string_view::npos) return false;
+            scratch.append(line.substr(i, quote - i));
+            if (quote + 1 < line.size() && line[quote + 1] == '"') {
+                scratch += '"';
+                i = quote + 2;
+                continue;
+            }
+            pos = quote + 1;
+            break;
+        }
+        if (pos >= line.size() || line[pos] != ',') return false;
+        name = scratch;
+    } else {
+        pos = line.find(',');
+        if (pos == string_view::npos) return false;
+        name = line.substr(0, pos);
+    }
+
+    string_view rest = line.substr(pos + 1);
+    size_t comma = rest.find(',');
+    if (comma == string_view::npos || !parseNumber(rest.substr(0, comma), quantity)) return false;
+    rest.remove_prefix(comma + 1);
+    comma = rest.find(',');
+    if (!parseNumber(rest.substr(0, comma), price)) return false;
+    visible = true;
+    return comma == string_view::npos || parseVisible(rest.substr(comma + 1), visible);
+}
+
+void importCsv(ChunkReader& reader, Importer& importer) {
+    string scratch;
+    bool firstLine = true;
+    for (;;) {
+        string_view data = reader.data();
+        size_t nl = data.find('\n');
+        if (nl == string_view::npos) {
+            if (reader.fill()) continue;
+            if (data.empty()) return;
+            nl = data.size();   // last line without a newline
+        }
+        string_view line = data.substr(0, nl);
+        reader.consume(min(nl + 1, data.size()));
+
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (line.empty()) continue;
+
+        string_view name;
+        int quantity = 0;
+        double price = 0;
+        bool visible = true;
+        bool parsed = parseCsvLine(line, scratch, name, quantity, price, visible);
+        // A first line that is not a row is the header.
+        bool header = firstLine && !parsed;
+        firstLine = false;
+        if (parsed) importer.add(name, quantity, price, visible);
+        else if (!header) importer.reject();
+    }
+}
+
+template <typename T>
+T load(const char* p) {
+    T value;
+    memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+constexpr size_t kFixedRecordBytes = sizeof(int32_t) + sizeof(double) + sizeof(uint8_t);
+
+void importBinary(ChunkReader& reader, Importer& importer, ImportResult& result) {
+    for (;;) {
+        string_view data = reader.data();
+        if (data.size() < sizeof(uint32_t)) {
+            if (reader.fill()) continue;
+            if (!data.empty()) result.error = "input ends inside a record";
+            return;
+        }
+        size_t nameLength = load<uint32_t>(data.data());
+        if (nameLength > kMaxNameLength) {
+            result.error = "corrupt record: name too long";
+            return;
+        }
+        size_t recordBytes = sizeof(uint32_t) + nameLength + kFixedRecordBytes;
+        if (data.size() < recordBytes) {
+            if (reader.fill()) continue;
+            result.error = "input ends inside a record";
+            return;
+        }
+        const char* p = data.data() + sizeof(uint32_t);
+        string_view name(p, nameLength);
+        p += nameLength;
+        int quantity = load<int32_t>(p);
+        double price = load<double>(p + sizeof(int32_t));
+        bool visible = load<uint8_t>(p + sizeof(int32_t) + sizeof(double)) != 0;
+        importer.add(name, quantity, price, visible);
+        reader.consume(recordBytes);
+    }
+}
+
+} // namespace
+
+ImportResult importInventory(seller& store, istream& in) {
+    auto started = chrono::steady_clock::now();
+    ImportResult result;
+    Importer importer(store, result);
+    ChunkReader reader(in);
+    reader.fill();
+
+    while (reader.data().size() < kInventoryMagic.size() && reader.fill()) {}
+    if (reader.data().substr(0, kInventoryMagic.size()) == kInventoryMagic) {
+        reader.consume(kInventoryMagic.size());
+        importBinary(reader, importer, result);
+    } else {
+        importCsv(reader, importer);
+    }
+    importer.commit();
+
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    return result;
+}
+
+void writeInventoryRecord(ostream& out, string_view name, int quantity, double price, bool visible) {
+    char tail[kFixedRecordBytes];
+    uint32_t nameLength = static_cast<uint32_t>(name.size());
+    int32_t qty = quantity;
+    uint8_t shown = visible ? 1 : 0;
+    memcpy(tail, &qty, sizeof(qty));
+    memcpy(tail + sizeof(qty), &price, sizeof(price));
+    memcpy(tail + sizeof(qty) + sizeof(price), &shown, sizeof(shown));
+    out.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+    out.write(name.data(), static_cast<streamsize>(name.size()));
+    out.write(tail, sizeof(tail));
+}
@@ -0,0 +1,47 @@
+#ifndef INVENTORY_IMPORT_H
+#define INVENTORY_IMPORT_H
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "seller.h"
+
+// Bulk catalog import for sellers.
+//
+// The input is read in large chunks and parsed as it arrives, so the
+// whole file is never held in memory. Valid rows are staged in batches.
+// Each batch takes one block of ids from itemIdCounter and goes into the
+// store under a single hold of inventoryMutex. The seller's item index and
+// the store-wide index grow once per batch.
+//
+// Two formats are accepted and told apart by the first bytes:
+//
+//   CSV     name,quantity,price[,visible]   one item per line, after an
+//           optional header line. The name may be quoted, with "" for a
+//           literal quote. visible is 1/0 or true/false (default 1).
+//   binary  kInventoryMagic, then records written by
+//           writeInventoryRecord(): u32 name length, name bytes,
+//           i32 quantity, f64 price, u8 visible (little-endian).
+//
+// Rows with an empty name, a negative quantity or a non-positive price are
+// skipped and counted; the rest are imported.
+inline constexpr std::string_view kInventoryMagic{"SKUBIN1\n", 8};
+
+struct ImportResult {
+    std::size_t imported = 0;
+    std::size_t rejected = 0;
+    int firstId = 0;              // ids handed out, 0 if none
+    int lastId = 0;
+    std::size_t firstRejectedRow = 0;   // 1-based line or record number
+    std::string error;            // set if the input ended mid-record
+    double seconds = 0;
+};
+
+ImportResult importInventory(seller& store, std::istream& in);
+
+void writeInventoryRecord(std::ostream& out, std::string_view name, int quantity, double price, bool visible);
+
+#endif // INVENTORY_IMPORT_H
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <iostream>
+#include <utility>
 
 using namespace std;
 
@@ -16,8 +17,8 @@ private:
 
 public:
     Item() = default;
-    Item(int id, const std::string& name, int quantity, double price)
-        : id(id), name(name), quantity(quantity), price(price) {
+    Item(int id, std::string name, int quantity, double price)
+        : id(id), name(std::move(name)), quantity(quantity), price(price) {
             idDisplay = false; 
         }
 
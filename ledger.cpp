@@ -0,0 +1,203 @@
+#include "ledger.h"
+#include "parallel_scan.h"
+#include "approx_analytics.h"
+#include "mpsc_ring.h"
+#include "trace.h"
+
+#include <thread>
+#include <variant>
+
+using namespace std;
+
+AppendLog<Transaction> allTransactions(memoryResource(MemoryTag::TRANSACTIONS));
+AppendLog<CashFlowLog> cashFlows(memoryResource(MemoryTag::CASH_FLOWS));
+LedgerColumns transactionColumns;
+LedgerColumns cashFlowColumns;
+
+namespace {
+
+// Published lengths of both logs packed into one word (transactions in the
+// high half), so a snapshot reads a pair that existed at a single instant.
+atomic<uint64_t> ledgerEpoch{0};
+
+void publishEpoch() {
+    uint64_t packed = (static_cast<uint64_t>(allTransactions.size()) << 32) | cashFlows.size();
+    ledgerEpoch.store(packed, memory_order_release);
+}
+
+uint8_t cashFlowFlag(const CashFlowLog& flow) {
+    return flow.getType() == "Debit" ? kDebitFlag : kCreditFlag;
+}
+
+void applyCashFlow(const CashFlowLog& flow) {
+    cashFlows.push_back(flow);
+    cashFlowColumns.append(flow.getTimestamp(), flow.getAccountId(), cashFlowFlag(flow), flow.getAmount());
+}
+
+void applyTransaction(const Transaction& transaction) {
+    allTransactions.push_back(transaction);
+    transactionColumns.append(transaction.getTimestamp(), transaction.getSellerId(), 0, transaction.getAmount());
+    analyticsSketches.observe(transaction);
+}
+
+// monostate asks the writer to stop once everything before it is applied.
+using LedgerEvent = variant<monostate, CashFlowLog, vector<CashFlowLog>, Transaction>;
+
+// Sole writer of the logs, their columns and the sketches. Producers push
+// events into a lock-free ring; the writer drains it in batches and
+// publishes each batch with a single epoch store, so a batch costs one
+// release store however many records it holds.
+class LedgerWriter {
+private:
+    static constexpr size_t kQueueSize = 4096;
+    static constexpr size_t kMaxBatch = 256;
+
+    MpscRing<LedgerEvent, kQueueSize> queue;
+    // Tickets applied so far; ticket n is visible once this reaches n.
+    atomic<uint64_t> applied{0};
+    thread worker;
+
+    void run() {
+        vector<LedgerEvent> batch;
+        batch.reserve(kMaxBatch);
+        uint64_t done = 0;
+        for (;;) {
+            size_t n = queue.popBatch(kMaxBatch, [&](LedgerEvent&& event) { batch.push_back(std::move(event)); });
+            if (n == 0) {
+                queue.waitForPush();
+                continue;
+            }
+
+            TRACE_SPAN("LedgerWriter::apply");
+            bool stopping = false;
+            for (const LedgerEvent& event : batch) {
+                if (const auto* flow = get_if<CashFlowLog>(&event)) applyCashFlow(*flow);
+                else if (const auto* flows = get_if<vector<CashFlowLog>>(&event)) {
+                    for (const auto& f : *flows) applyCashFlow(f);
+                }
+                else if (const auto* transaction = get_if<Transaction>(&event)) applyTransaction(*transaction);
+                else stopping = true;
+            }
+            batch.clear();
+
+            publishEpoch();
+            done += n;
+            applied.store(done, memory_order_release);
+            applied.notify_all();
+            if (stopping) return;
+        }
+    }
+
+public:
+    LedgerWriter() : worker([this] { run(); }) {}
+
+    ~LedgerWriter() {
+        queue.push(monostate{});
+        worker.join();
+    }
+
+    template <typename Event>
+    LedgerTicket submit(Event&& event) {
+        return LedgerTicket{queue.push(std::forward<Event>(event))};
+    }
+
+    uint64_t lastSubmitted() const { return queue.pushed(); }
+
+    bool isApplied(uint64_t ticket) const { return applied.load(memory_order_acquire) >= ticket; }
+
+    void waitFor(uint64_t ticket) const {
+        uint64_t seen = applied.load(memory_order_acquire);
+        while (seen < ticket) {
+            applied.wait(seen, memory_order_acquire);
+            seen = applied.load(memory_order_acquire);
+        }
+    }
+};
+
+// Started on first use, so it is destroyed (and drained) before the logs
+// and the sketches it writes to.
+LedgerWriter& ledgerWriter() {
+    static LedgerWriter writer;
+    return writer;
+}
+
+constexpr size_t kMinParallelBlocks = kMinParallelChunk / ColumnBlock::kRows;
+
+} // namespace
+
+bool LedgerTicket::visible() const { return ledgerWriter().isApplied(sequence); }
+
+void LedgerTicket::wait() const { ledgerWriter().waitFor(sequence); }
+
+LedgerTicket recordCashFlow(const CashFlowLog& flow) {
+    TRACE_SPAN("recordCashFlow");
+    return ledgerWriter().submit(flow);
+}
+
+LedgerTicket recordCashFlows(vector<CashFlowLog> flows) {
+    TRACE_SPAN("recordCashFlows");
+    return ledgerWriter().submit(std::move(flows));
+}
+
+LedgerTicket recordTransaction(const Transaction& transaction) {
+    TRACE_SPAN("recordTransaction");
+    return ledgerWriter().submit(transaction);
+}
+
+void syncLedger() {
+    LedgerWriter& writer = ledgerWriter();
+    writer.waitFor(writer.lastSubmitted());
+}
+
+LedgerSnapshot ledgerSnapshot() {
+    uint64_t packed = ledgerEpoch.load(memory_order_acquire);
+    return LedgerSnapshot{
+        AppendLog<Transaction>::View(&allTransactions, static_cast<size_t>(packed >> 32)),
+        AppendLog<CashFlowLog>::View(&cashFlows, static_cast<size_t>(packed & 0xFFFFFFFFULL)),
+    };
+}
+
+vector<size_t> selectRows(const LedgerColumns& columns, const RowFilter& filter) {
+    size_t rows = columns.size();
+    auto partials = parallelChunks(columns.blockCount(rows), [&](size_t begin, size_t end) {
+        vector<size_t> hits;
+        for (size_t b = begin; b < end; ++b) {
+            size_t first = hits.size();
+            filterSelect(columns.blockView(b, rows), filter, hits);
+            for (size_t i = first; i < hits.size(); ++i) hits[i] += b * ColumnBlock::kRows;
+        }
+        return hits;
+    }, analyticsPool(), kMinParallelBlocks);
+
+    vector<size_t> result = std::move(partials.front());
+    for (size_t i = 1; i < partials.size(); ++i) {
+        result.insert(result.end(), partials[i].begin(), partials[i].end());
+    }
+    return result;
+}
+
+size_t countRows(const LedgerColumns& columns, const RowFilter& filter) {
+    size_t rows = columns.size();
+    auto partials = parallelChunks(columns.blockCount(rows), [&](size_t begin, size_t end) {
+        size_t n = 0;
+        for (size_t b = begin; b < end; ++b) n += filterCount(columns.blockView(b, rows), filter);
+        return n;
+    }, analyticsPool(), kMinParallelBlocks);
+
+    size_t total = 0;
+    for (size_t n : partials) total += n;
+    return total;
+}
+
+double sumRows(const LedgerColumns& columns, const RowFilter& filter) {
+    size_t rows = columns.size();
+    auto partials = parallelChunks(columns.blockCount(rows), [&](size_t begin, size_t end) {
+        double sum = 0.0;
+        for (size_t b = begin; b < end; ++b) sum += filterSum(columns.blockView(b, rows), filter);
+        return sum;
+    }, analyticsPool(), kMinParallelBlocks);
+
+    double total = 0.0;
+    for (double s : partials) total += s;
+    return total;
+}
@@ -0,0 +1,117 @@
+#ifndef LEDGER_H
+#define LEDGER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "append_log.h"
+#include "cash_flow_log.h"
+#include "column_kernels.h"
+#include "memory_accounting.h"
+#include "transaction.h"
+
+inline int64_t toLedgerTime(chrono::system_clock::time_point tp) {
+    return chrono::duration_cast<chrono::nanoseconds>(tp.time_since_epoch()).count();
+}
+
+// One block of a columnar log. Rows inside a block are contiguous, so the
+// SIMD kernels run over a whole block at a time.
+struct ColumnBlock {
+    static constexpr size_t kRows = 4096;
+
+    int64_t timestamps[kRows];
+    int32_t ids[kRows];
+    uint8_t flags[kRows];
+    double amounts[kRows];
+
+    ColumnView view(size_t rows) const {
+        return ColumnView{timestamps, ids, flags, amounts, rows};
+    }
+};
+
+// Columnar mirror of a log: one entry per record, same order as the log.
+// Cash flows store the account id and a debit flag; transactions store the
+// seller id and leave the flag at 0. Blocks never move, and the row count
+// is published after the row is written, so readers need no lock.
+// Only the ledger writer thread appends.
+class LedgerColumns {
+private:
+    AppendLog<ColumnBlock, 16> blocks{memoryResource(MemoryTag::LEDGER_COLUMNS)};
+    std::atomic<size_t> rows{0};
+
+public:
+    void append(chrono::system_clock::time_point ts, int id, uint8_t flag, double amount) {
+        size_t n = rows.load(std::memory_order_relaxed);
+        if (n % ColumnBlock::kRows == 0) blocks.emplace_back();
+        ColumnBlock& block = blocks[n / ColumnBlock::kRows];
+        size_t r = n % ColumnBlock::kRows;
+        block.timestamps[r] = toLedgerTime(ts);
+        block.ids[r] = id;
+        block.flags[r] = flag;
+        block.amounts[r] = amount;
+        rows.store(n + 1, std::memory_order_release);
+    }
+
+    size_t size() const { return rows.load(std::memory_order_acquire); }
+
+    size_t blockCount(size_t rowCount) const { return (rowCount + ColumnBlock::kRows - 1) / ColumnBlock::kRows; }
+
+    // Kernel view of block `b`, clipped to the first `rowCount` rows.
+    ColumnView blockView(size_t b, size_t rowCount) const {
+        size_t first = b * ColumnBlock::kRows;
+        size_t n = std::min(ColumnBlock::kRows, rowCount - first);
+        return blocks[b].view(n);
+    }
+};
+
+constexpr int kDebitFlag = 1;
+constexpr int kCreditFlag = 0;
+
+extern AppendLog<Transaction> allTransactions;
+extern AppendLog<CashFlowLog> cashFlows;
+extern LedgerColumns transactionColumns;
+extern LedgerColumns cashFlowColumns;
+
+// Completion handle for a queued ledger write. Tickets are issued in queue
+// order, and the writer applies events in that order, so once a ticket is
+// visible every earlier one is too.
+struct LedgerTicket {
+    uint64_t sequence = 0;
+
+    // True once the event is in the logs, the columns and the sketches and
+    // ledgerSnapshot() includes it.
+    bool visible() const;
+    void wait() const;
+};
+
+// Every append to the logs goes through these so the columns stay in step.
+// They only enqueue the event for the ledger writer thread, which applies
+// queued events in batches; wait on the ticket to read your own write.
+LedgerTicket recordCashFlow(const CashFlowLog& flow);
+// The entries become visible together; readers see none or all of them.
+LedgerTicket recordCashFlows(std::vector<CashFlowLog> flows);
+LedgerTicket recordTransaction(const Transaction& transaction);
+
+// Blocks until every event recorded before the call is visible.
+void syncLedger();
+
+// Read-only views of both logs: the rows a report iterates are fixed when
+// the snapshot is taken, so appends made afterwards do not affect them.
+// Only the set of rows is fixed, not their mutable fields (AppendLog::View).
+struct LedgerSnapshot {
+    AppendLog<Transaction>::View transactions;
+    AppendLog<CashFlowLog>::View cashFlows;
+};
+
+LedgerSnapshot ledgerSnapshot();
+
+// Indices of matching rows in storage order, scanned in parallel by block.
+// Every returned index is valid in the corresponding record log.
+std::vector<size_t> selectRows(const LedgerColumns& columns, const RowFilter& filter);
+size_t countRows(const LedgerColumns& columns, const RowFilter& filter);
+double sumRows(const LedgerColumns& columns, const RowFilter& filter);
+
+#endif // LEDGER_H
@@ -0,0 +1,220 @@
+// Load generator for `my_app --server`: opens N loopback connections, each
+// registering its own buyer, and pipelines a fixed command mix at the
+// server for a set time. Reports requests per second.
+//
+//   loadgen [--port P] [--connections N] [--depth D] [--seconds S]
+//           [--commands "CMD;CMD;..."]
+//
+// In --commands, {item} stands for the item the generator stocks for the
+// run; the default mix deposits, shops, pays and reads a few reports.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+struct Options {
+    uint16_t port = 7070;
+    int connections = 8;
+    int depth = 32;
+    double seconds = 5.0;
+    string commands = "BALANCE;DEPOSIT 20;ADD {item} 1;CHECKOUT;PAY;WITHDRAW 5;BROWSE;PAYSTATS";
+};
+
+struct Reply {
+    bool ok;
+    string body;
+};
+
+// Blocking client connection with a read buffer for reply framing.
+class Client {
+private:
+    int fd;
+    string buffer;
+    size_t pos = 0;
+
+    void fill() {
+        if (pos == buffer.size()) {
+            buffer.clear();
+            pos = 0;
+        }
+        char chunk[64 * 1024];
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) throw runtime_error("connection closed by server");
+        buffer.append(chunk, static_cast<size_t>(n));
+    }
+
+public:
+    explicit Client(uint16_t port) {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            throw runtime_error(string("connect: ") + strerror(errno));
+        }
+        int yes = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    }
+    ~Client() { close(fd); }
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    void send(const string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) throw runtime_error("send failed");
+            sent += static_cast<size_t>(n);
+        }
+    }
+
+    Reply receive() {
+        size_t nl;
+        while ((nl = buffer.find('\n', pos)) == string::npos) fill();
+        string header = buffer.substr(pos, nl - pos);
+        pos = nl + 1;
+        size_t space = header.find(' ');
+        if (space == string::npos) throw runtime_error("bad reply header: " + header);
+        size_t length = stoul(header.substr(space + 1));
+        while (buffer.size() - pos < length) fill();
+        Reply reply{header.compare(0, space, "OK") == 0, buffer.substr(pos, length)};
+        pos += length;
+        return reply;
+    }
+
+    Reply call(const string& line) {
+        send(line + "\n");
+        return receive();
+    }
+};
+
+vector<string> expandCommands(const string& spec, int item) {
+    vector<string> out;
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t end = spec.find(';', start);
+        if (end == string::npos) end = spec.size();
+        string cmd = spec.substr(start, end - start);
+        for (size_t p; (p = cmd.find("{item}")) != string::npos;) cmd.replace(p, 6, to_string(item));
+        if (!cmd.empty()) out.push_back(cmd);
+        start = end + 1;
+    }
+    return out;
+}
+
+// Registers a seller with a practically unlimited item and returns its id.
+int stockItem(uint16_t port) {
+    Client setup(port);
+    setup.call("REGISTER 0 loadgen-seller");
+    setup.call("UPGRADE Loadgen Supplies");
+    Reply item = setup.call("ITEM 1000000000 1.00 Loadgen Widget");
+    if (!item.ok || item.body.compare(0, 5, "item ") != 0) throw runtime_error("could not stock item: " + item.body);
+    setup.call("QUIT");
+    return stoi(item.body.substr(5));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string flag = argv[i];
+        if (flag == "--port") opt.port = static_cast<uint16_t>(atoi(argv[i + 1]));
+        else if (flag == "--connections") opt.connections = atoi(argv[i + 1]);
+        else if (flag == "--depth") opt.depth = atoi(argv[i + 1]);
+        else if (flag == "--seconds") opt.seconds = atof(argv[i + 1]);
+        else if (flag == "--commands") opt.commands = argv[i + 1];
+        else {
+            cerr << "unknown option " << flag << endl;
+            return 1;
+        }
+    }
+    if (opt.connections <= 0 || opt.depth <= 0 || opt.seconds <= 0) {
+        cerr << "connections, depth and seconds must be positive" << endl;
+        return 1;
+    }
+
+    vector<string> mix;
+    try {
+        mix = expandCommands(opt.commands, stockItem(opt.port));
+    } catch (const exception& e) {
+        cerr << "loadgen: " << e.what() << endl;
+        return 1;
+    }
+    if (mix.empty()) {
+        cerr << "loadgen: empty command mix" << endl;
+        return 1;
+    }
+
+    atomic<uint64_t> okCount{0}, errCount{0}, batchMicros{0}, batchCount{0};
+    atomic<bool> failed{false};
+    auto started = chrono::steady_clock::now();
+    auto deadline = started + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(opt.seconds));
+
+    vector<thread> workers;
+    for (int c = 0; c < opt.connections; ++c) {
+        workers.emplace_back([&, c] {
+            try {
+                Client client(opt.port);
+                client.call("REGISTER 1000000 loadgen-" + to_string(c));
+                size_t next = 0;
+                uint64_t ok = 0, err = 0;
+                string batch;
+                while (chrono::steady_clock::now() < deadline) {
+                    batch.clear();
+                    for (int i = 0; i < opt.depth; ++i) {
+                        batch += mix[next];
+                        batch += '\n';
+                        next = (next + 1) % mix.size();
+                    }
+                    auto sent = chrono::steady_clock::now();
+                    client.send(batch);
+                    for (int i = 0; i < opt.depth; ++i) {
+                        if (client.receive().ok) ++ok; else ++err;
+                    }
+                    batchMicros += static_cast<uint64_t>(
+                        chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - sent).count());
+                    ++batchCount;
+                }
+                client.call("QUIT");
+                okCount += ok;
+                errCount += err;
+            } catch (const exception& e) {
+                cerr << "loadgen: connection " << c << ": " << e.what() << endl;
+                failed = true;
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    uint64_t total = okCount + errCount;
+    cout << fixed << setprecision(2);
+    cout << "Requests: " << total << " (" << okCount << " OK, " << errCount << " ERR) in " << elapsed << " s" << endl;
+    cout << "Throughput: " << total / elapsed << " requests/s over " << opt.connections
+         << " connections, pipeline depth " << opt.depth << endl;
+    if (batchCount > 0) {
+        cout << "Mean batch round trip: " << static_cast<double>(batchMicros) / static_cast<double>(batchCount) << " us" << endl;
+    }
+    return failed ? 1 : 0;
+}
@@ -3,494 +3,610 @@
 #include <string>
 #include <limits>
 #include <algorithm>
+#include <charconv>
 #include <stdexcept>
 #include <map>
 #include <cmath>
 #include <chrono>
 #include <ctime>
 #include <iomanip>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
 
 #include "bank_customer.h"
-#include "buyer.h"         
-#include "seller.h"        
-#include "bank.h"          
+#include "buyer.h"
+#include "seller.h"
+#include "bank.h"
+#include "clock.h"
 #include "transaction.h"
 #include "cash_flow_log.h"
+#include "inventory_import.h"
+#include "ledger.h"
+#include "memory_accounting.h"
+#include "metrics.h"
 #include "order.h"
+#include "parallel_scan.h"
+#include "approx_analytics.h"
+#include "payment_engine.h"
+#include "reports.h"
+#include "protocol.h"
+#include "replay.h"
+#include "server.h"
+#include "session.h"
+#include "store.h"
+#include "task.h"
+#include "trace.h"
+#include "workload.h"
 
 using namespace std;
 
 enum PrimaryPrompt { LOGIN, REGISTER, STORE_CAPABILITIES, BANK_ANALYSIS, EXIT };
 
-Bank myBank("Global Commerce Bank");
-
-vector<Buyer> buyers;
-vector<seller> sellers;
-vector<Transaction> allTransactions; 
-vector<CashFlowLog> cashFlows; 
-
-int buyerIdCounter = 0;
-int itemIdCounter = 0; 
-int transactionIdCounter = 0; 
-int orderIdCounter = 0;
-
-bool isLoggedIn = false;
-Buyer* currentBuyer = nullptr;
-seller* currentSeller = nullptr;
-
-void handleRegister();
-void handleLogin();
-Buyer* findBuyer(int id);
-seller* findSeller(int buyerId);
-seller* findSellerByItem(int itemId);
-Item* findItemInStore(int itemId, seller*& itemSeller);
-
-void buyerMenu();
-void sellerMenu();
-void bankingFunctions(BankCustomer& account);
-void upgradeToSeller();
-
-void browseStoreFunctionality();
-void orderFunctionality();
-void paymentFunctionality();
-void checkSpendingLastKDays(int k);
-void cashFlowMenu(BankCustomer& account);
-
-void itemManagementMenu();
-void discoverTopItemsPerMonth();
-void discoverLoyalCustomerPerMonth();
-
-void storeCapabilitiesMenu(); 
-void bankAnalysisMenu(); 
-void listRecentTransactions(int k);
-void listUncompletedTransactions();
-void listMostFrequentItems(int m);
-void listMostActiveUsers(const string& type, int (Transaction::*getIdFunc)() const);
-void listMostActiveBuyers();
-void listMostActiveSellers();
-
-
-int main() {
-    cout << fixed << setprecision(2);
+Task<> mainMenu(Session& s);
+Task<> handleRegister(Session& s);
+Task<> handleLogin(Session& s);
+
+Task<> buyerMenu(Session& s);
+Task<> sellerMenu(Session& s);
+Task<> upgradeToSeller(Session& s);
+
+Task<> browseStoreFunctionality(Session& s);
+Task<> orderFunctionality(Session& s);
+Task<> paymentFunctionality(Session& s);
+Task<> cashFlowMenu(Session& s, BankCustomer& account);
+
+Task<> itemManagementMenu(Session& s);
+Task<> discoverTopItemsPerMonth(Session& s);
+
+Task<> storeCapabilitiesMenu(Session& s);
+Task<> bankAnalysisMenu(Session& s);
+
 
+namespace {
+
+LoopbackServer* runningServer = nullptr;
+
+void stopServer(int) {
+    if (runningServer) runningServer->stop();
+}
+
+} // namespace
+
+void seedStore() {
     try {
         BankCustomer& aliceAcc = myBank.createAccount("Alice", 2000.0, "Jl. Utama", "08123", "alice@test.com");
-        buyers.emplace_back(++buyerIdCounter, "Alice", aliceAcc); 
-        Buyer& aliceBuyer = buyers.back();
-        sellers.emplace_back(aliceBuyer, aliceBuyer.getId(), "Alice's Marketplace");
+        printAccountCreated(aliceAcc, cout);
+        Buyer& aliceBuyer = addBuyer("Alice", aliceAcc);
+        seller& aliceStore = sellers.emplace_back(aliceBuyer, aliceBuyer.getId(), "Alice's Marketplace");
 
         BankCustomer& bobAcc = myBank.createAccount("Bob", 500.0, "Jl. Kedua", "08987", "bob@test.com");
-        buyers.emplace_back(++buyerIdCounter, "Bob", bobAcc);
-        
+        printAccountCreated(bobAcc, cout);
+        addBuyer("Bob", bobAcc);
+
         BankCustomer& charlieAcc = myBank.createAccount("Charlie", 1000.0, "Jl. Ketiga", "08888", "charlie@test.com");
-        buyers.emplace_back(++buyerIdCounter, "Charlie", charlieAcc);
+        printAccountCreated(charlieAcc, cout);
+        addBuyer("Charlie", charlieAcc);
 
-        itemIdCounter++; 
-        sellers.front().addNewItem(itemIdCounter, "Laptop Gaming", 5, 1200.0);
-        sellers.front().makeItemVisibleToCustomer(itemIdCounter);
-        itemIdCounter++; 
-        sellers.front().addNewItem(itemIdCounter, "Mouse Wireless", 10, 50.0);
-        sellers.front().makeItemVisibleToCustomer(itemIdCounter);
+        {
+            unique_lock<shared_mutex> lock(inventoryMutex);
+            addStoreItem(aliceStore, "Laptop Gaming", 5, 1200.0);
+            addStoreItem(aliceStore, "Mouse Wireless", 10, 50.0);
+        }
 
         Order dummyOrder(++orderIdCounter, aliceBuyer.getId());
         dummyOrder.addItem(1, "Laptop Gaming", 1200.0, 1, aliceBuyer.getId());
         dummyOrder.markAsPaid();
-        aliceBuyer.getOrders().push_back(dummyOrder);
-        
-        allTransactions.emplace_back(++transactionIdCounter, aliceBuyer.getId(), sellers.front().getId(), "Laptop Gaming", 1200.0);
-        
+        aliceBuyer.addOrder(dummyOrder);
+
+        recordTransaction(Transaction(++transactionIdCounter, aliceBuyer.getId(), aliceStore.getId(), "Laptop Gaming", 1200.0));
+
     } catch (const exception& e) {
         cerr << "Initialization Error: " << e.what() << endl;
     }
+}
 
+// Serves the command protocol on 127.0.0.1:<port> until SIGINT/SIGTERM,
+// appending every request to `recordPath` if one is given.
+int runServer(uint16_t port, const string& recordPath) {
+    ofstream recording;
+    if (!recordPath.empty()) {
+        recording.open(recordPath);
+        if (!recording) {
+            cerr << "Cannot write " << recordPath << endl;
+            return 1;
+        }
+        recordCommands(&recording);
+    }
 
+    SessionRuntime runtime(commandSession);
+    try {
+        LoopbackServer server(runtime, port);
+        runningServer = &server;
+        signal(SIGINT, stopServer);
+        signal(SIGTERM, stopServer);
+        cout << "Listening on 127.0.0.1:" << server.getPort() << endl;
+        server.run();
+        runningServer = nullptr;
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        recordCommands(nullptr);
+        return 1;
+    }
+    recordCommands(nullptr);
+    return 0;
+}
+
+void printUsage(const char* program) {
+    cerr << "usage: " << program << " [--workload spec]                        interactive menus\n"
+         << "       " << program << " [--workload spec] --server [port] [--record file]\n"
+         << "       " << program << " [--workload spec] --replay file [--repeat n] [--echo]\n"
+         << "  spec: key=value,... with keys seed, accounts, sellers, itemsPerSeller, events, days, zipf\n"
+         << "  any mode: --metrics-dump file [--metrics-interval seconds]   rewrite hot-path metrics periodically\n"
+         << "            --trace file [--trace-every n]   sample 1 in n operations, Chrome trace JSON at exit\n"
+         << "            --clock system|coarse|simulated   coarse: 1 ms resolution; simulated: CLOCK ADVANCE in a replay moves time\n"
+         << "            --data-dir dir   where protocol commands may read and write files (default: nowhere)"
+         << endl;
+}
+
+int main(int argc, char** argv) {
+    cout << fixed << setprecision(2);
+    seedStore();
+
+    string mode;
+    int port = 7070;
+    string recordPath;
+    ReplayOptions replay;
+    WorkloadOptions workload;
+    bool generate = false;
+    string metricsPath;
+    int metricsInterval = 60;
+    string tracePath;
+    int traceEvery = 1;
+    string clockName = "system";
+    for (int i = 1; i < argc; ++i) {
+        string flag = argv[i];
+        if (flag == "--server" && mode.empty()) {
+            mode = flag;
+            if (i + 1 < argc && argv[i + 1][0] != '-') port = atoi(argv[++i]);
+        }
+        else if (flag == "--replay" && mode.empty() && i + 1 < argc) { mode = flag; replay.path = argv[++i]; }
+        else if (flag == "--record" && i + 1 < argc) recordPath = argv[++i];
+        else if (flag == "--repeat" && i + 1 < argc) replay.repeat = atoi(argv[++i]);
+        else if (flag == "--echo") replay.echo = true;
+        else if (flag == "--metrics-dump" && i + 1 < argc) metricsPath = argv[++i];
+        else if (flag == "--metrics-interval" && i + 1 < argc) metricsInterval = atoi(argv[++i]);
+        else if (flag == "--trace" && i + 1 < argc) tracePath = argv[++i];
+        else if (flag == "--trace-every" && i + 1 < argc) traceEvery = atoi(argv[++i]);
+        else if (flag == "--clock" && i + 1 < argc) clockName = argv[++i];
+        else if (flag == "--data-dir" && i + 1 < argc) setProtocolDataDir(argv[++i]);
+        else if (flag == "--workload" && i + 1 < argc && parseWorkloadSpec(argv[i + 1], workload)) { generate = true; ++i; }
+        else { printUsage(argv[0]); return 1; }
+    }
+    bool valid = mode.empty() || (mode == "--server" && port >= 0 && port <= 65535) ||
+                 (mode == "--replay" && !replay.path.empty() && replay.repeat > 0);
+    bool knownClock = clockName == "system" || clockName == "coarse" || clockName == "simulated";
+    if (!valid || metricsInterval <= 0 || traceEvery <= 0 || !knownClock) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (!metricsPath.empty() && !startMetricsDump(metricsPath, chrono::seconds(metricsInterval))) {
+        cerr << "cannot write metrics to " << metricsPath << endl;
+        return 1;
+    }
+    if (clockName == "coarse") useCoarseClock();
+    else if (clockName == "simulated") useSimulatedClock(clockNow());
+    if (!tracePath.empty()) {
+        writeTraceAtExit(tracePath);
+        setTraceSampling(static_cast<unsigned>(traceEvery));
+    }
+
+    if (generate) {
+        WorkloadSummary w = generateWorkload(workload);
+        cout << "Workload: " << w.accounts << " accounts, " << w.sellers << " sellers, " << w.items << " items, "
+             << w.paidOrders << " paid and " << w.unpaidOrders << " unpaid orders, " << w.deposits << " deposits, "
+             << w.withdrawals << " withdrawals (" << w.declined << " declined) in " << w.seconds << " s" << endl;
+    }
+    if (mode == "--server") return runServer(static_cast<uint16_t>(port), recordPath);
+    if (mode == "--replay") return runReplay(replay, cout);
+
+    // The terminal is one session of the runtime; it reads a line only
+    // once the menus are waiting for one.
+    SessionRuntime runtime(mainMenu, 1);
+    int console = runtime.open([](string_view text) { cout << text << flush; });
+    while (runtime.waitForPrompt(console)) {
+        string line;
+        if (getline(cin, line)) {
+            runtime.feed(console, line + "\n");
+        } else {
+            runtime.close(console);
+        }
+    }
+
+    return 0;
+}
+
+Task<> mainMenu(Session& s) {
+    ostream& out = s.out;
     PrimaryPrompt prompt = LOGIN;
     while (prompt != EXIT) {
-        cout << "\n===================================" << endl;
-        cout << "MAIN MENU" << endl;
-        cout << "1. Login" << endl;
-        cout << "2. Register" << endl;
-        cout << "3. Store Capabilities (Admin/General Analysis)" << endl; 
-        cout << "4. Bank Analysis (Admin/General Analysis)" << endl; 
-        cout << "5. Exit" << endl; 
-        cout << "===================================" << endl;
+        out << "\n===================================" << endl;
+        out << "MAIN MENU" << endl;
+        out << "1. Login" << endl;
+        out << "2. Register" << endl;
+        out << "3. Store Capabilities (Admin/General Analysis)" << endl;
+        out << "4. Bank Analysis (Admin/General Analysis)" << endl;
+        out << "5. Exit" << endl;
+        out << "===================================" << endl;
 
         int choice;
-        cout << "Pilihan >> ";
-        if (!(cin >> choice)) {
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        out << "Pilihan >> ";
+        if (!co_await s.read(choice)) {
             choice = 0;
         }
 
         if (choice < 1 || choice > 5) {
-            cout << "Invalid option." << endl;
+            out << "Invalid option." << endl;
             continue;
         }
-        
-        prompt = static_cast<PrimaryPrompt>(choice - 1); 
+
+        prompt = static_cast<PrimaryPrompt>(choice - 1);
         switch (prompt) {
             case LOGIN:
-                handleLogin();
+                co_await handleLogin(s);
                 break;
             case REGISTER:
-                handleRegister();
+                co_await handleRegister(s);
                 break;
             case STORE_CAPABILITIES:
-                storeCapabilitiesMenu();
+                co_await storeCapabilitiesMenu(s);
                 break;
             case BANK_ANALYSIS:
-                bankAnalysisMenu();
+                co_await bankAnalysisMenu(s);
                 break;
             case EXIT:
-                cout << "Exiting program." << std::endl;
+                out << "Exiting program." << std::endl;
                 break;
         }
     }
-
-    return 0;
-}
-
-Buyer* findBuyer(int id) {
-    for (auto& b : buyers) {
-        if (b.getId() == id) return &b;
-    }
-    return nullptr;
-}
-
-seller* findSeller(int buyerId) {
-    for (auto& s : sellers) {
-        if (s.getId() == buyerId) return &s; 
-    }
-    return nullptr;
-}
-
-seller* findSellerByItem(int itemId) {
-    for (auto& s : sellers) {
-        if (s.findItemById(itemId)) {
-            return &s;
-        }
-    }
-    return nullptr;
-}
-
-Item* findItemInStore(int itemId, seller*& itemSeller) {
-    for (auto& s : sellers) {
-        if (Item* item = s.findItemById(itemId)) {
-            itemSeller = &s;
-            return item;
-        }
-    }
-    itemSeller = nullptr;
-    return nullptr;
 }
 
-void handleRegister() {
-    cout << "\n--- REGISTRATION ---" << endl;
+Task<> handleRegister(Session& s) {
+    ostream& out = s.out;
+    out << "\n--- REGISTRATION ---" << endl;
     string name, address, phone, email, storeName;
     double initialDeposit;
     char isSeller;
 
-    cout << "Enter Name: "; cin.ignore(); getline(cin, name);
-    cout << "Enter Home Address: "; getline(cin, address);
-    cout << "Enter Phone number: "; getline(cin, phone);
-    cout << "Enter Email: "; getline(cin, email);
-    cout << "Enter Initial Deposit Amount: $"; 
-    while (!(cin >> initialDeposit) || initialDeposit < 0) {
-        cout << "Invalid amount. Enter Initial Deposit Amount: $";
-        cin.clear();
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    out << "Enter Name: "; co_await s.readLine(name);
+    out << "Enter Home Address: "; co_await s.readLine(address);
+    out << "Enter Phone number: "; co_await s.readLine(phone);
+    if (myBank.findCustomerByPhone(phone)) {
+        out << "Registration Failed: phone number already registered" << endl;
+        co_return;
     }
-    
+    out << "Enter Email: "; co_await s.readLine(email);
+    if (myBank.findCustomerByEmail(email)) {
+        out << "Registration Failed: email already registered" << endl;
+        co_return;
+    }
+    out << "Enter Initial Deposit Amount: $";
+    while (!co_await s.read(initialDeposit) || initialDeposit < 0) {
+        out << "Invalid amount. Enter Initial Deposit Amount: $";
+    }
+
     try {
         BankCustomer& newAcc = myBank.createAccount(name, initialDeposit, address, phone, email);
-        buyers.emplace_back(++buyerIdCounter, name, newAcc);
-        Buyer& newBuyer = buyers.back();
-        
-        cout << "Buyer account created (ID: " << newBuyer.getId() << ").\n";
-
-        cout << "Do you want to create a Seller Account now? (y/n): "; 
-        cin >> isSeller;
-        
+        printAccountCreated(newAcc, out);
+        Buyer& newBuyer = addBuyer(name, newAcc);
+
+        out << "Buyer account created (ID: " << newBuyer.getId() << ").\n";
+
+        out << "Do you want to create a Seller Account now? (y/n): ";
+        co_await s.read(isSeller);
+
         if (tolower(isSeller) == 'y') {
-            cout << "Enter Store Name: "; cin.ignore(); getline(cin, storeName);
-            sellers.emplace_back(newBuyer, newBuyer.getId(), storeName);
-            cout << "Seller account created (Store Name: " << storeName << ").\n";
-        }
-        
-        currentBuyer = &newBuyer;
-        currentSeller = findSeller(newBuyer.getId());
-        cout << "\nRegistration complete. Logged in as " << currentBuyer->getName() << ".\n";
-        
-        buyerMenu(); 
-        
+            out << "Enter Store Name: "; co_await s.readLine(storeName);
+            if (addSeller(newBuyer, storeName)) {
+                out << "Seller account created (Store Name: " << storeName << ").\n";
+            } else {
+                out << "Seller account already exists.\n";
+            }
+        }
+
+        s.currentBuyer = &newBuyer;
+        s.currentSeller = findSeller(newBuyer.getId());
+        out << "\nRegistration complete. Logged in as " << s.currentBuyer->getName() << ".\n";
+
+        co_await buyerMenu(s);
+
+    } catch (const SessionClosed&) {
+        throw;
     } catch (const exception& e) {
-        cerr << "Registration Failed: " << e.what() << endl;
+        out << "Registration Failed: " << e.what() << endl;
     }
 }
 
-void handleLogin() {
-    cout << "\n--- LOGIN ---" << endl;
-    int id;
-    cout << "Enter Buyer ID: "; 
-    if (!(cin >> id)) {
-        cout << "Invalid ID format." << endl;
-        cin.clear();
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
-        return;
+Task<> handleLogin(Session& s) {
+    ostream& out = s.out;
+    out << "\n--- LOGIN ---" << endl;
+    string login;
+    out << "Enter Buyer ID or Email: ";
+    co_await s.read(login);
+
+    int id = 0;
+    auto [end, ec] = from_chars(login.data(), login.data() + login.size(), id);
+    if (ec == errc() && end == login.data() + login.size()) {
+        s.currentBuyer = findBuyer(id);
+    } else if (login.find('@') != string::npos) {
+        s.currentBuyer = findBuyerByEmail(login);
+    } else {
+        out << "Invalid ID format." << endl;
+        co_return;
     }
 
-    currentBuyer = findBuyer(id);
-
-    if (currentBuyer) {
-        currentSeller = findSeller(id);
-        cout << "Login successful. Welcome, " << currentBuyer->getName() << " (ID: " << currentBuyer->getId() << ")!\n";
-        isLoggedIn = true;
-        buyerMenu();
+    if (s.currentBuyer) {
+        s.currentSeller = findSeller(s.currentBuyer->getId());
+        out << "Login successful. Welcome, " << s.currentBuyer->getName() << " (ID: " << s.currentBuyer->getId() << ")!\n";
+        s.isLoggedIn = true;
+        co_await buyerMenu(s);
     } else {
-        cout << "Login failed. Buyer ID not found.\n";
+        out << "Login failed. Buyer not found.\n";
     }
 }
 
 
-void buyerMenu() {
+Task<> buyerMenu(Session& s) {
+    ostream& out = s.out;
     int choice;
     do {
-        bool isSeller = (currentSeller != nullptr);
-        
-        cout << "\n--- BUYER MENU (User: " << currentBuyer->getName() << ") ---" << endl;
-        cout << "1. Check Account Status" << endl;
-        
+        bool isSeller = (s.currentSeller != nullptr);
+
+        out << "\n--- BUYER MENU (User: " << s.currentBuyer->getName() << ") ---" << endl;
+        out << "1. Check Account Status" << endl;
+
         if (!isSeller) {
-            cout << "2. Upgrade Account to Seller" << endl;
+            out << "2. Upgrade Account to Seller" << endl;
         } else {
-            cout << "2. Go to Seller Menu" << endl; 
+            out << "2. Go to Seller Menu" << endl;
         }
-        
+
         int offset = (isSeller ? 1 : 0);
-        
-        cout << 2 + offset << ". Banking Functions (Topup/Withdraw/Cash Flow)" << endl;
-        cout << 3 + offset << ". Browse Store & Purchase" << endl;
-        cout << 4 + offset << ". Order Functionality (List/Filter)" << endl;
-        cout << 5 + offset << ". Check Spending Last K Days" << endl; 
-        cout << 6 + offset << ". Logout" << endl;
-        cout << 7 + offset << ". Delete Account (DUMMY)" << endl;
-
-        cout << "Pilihan >> ";
-        if (!(cin >> choice)) {
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+
+        out << 2 + offset << ". Banking Functions (Topup/Withdraw/Cash Flow)" << endl;
+        out << 3 + offset << ". Browse Store & Purchase" << endl;
+        out << 4 + offset << ". Order Functionality (List/Filter)" << endl;
+        out << 5 + offset << ". Check Spending Last K Days" << endl;
+        out << 6 + offset << ". Logout" << endl;
+        out << 7 + offset << ". Delete Account (DUMMY)" << endl;
+
+        out << "Pilihan >> ";
+        if (!co_await s.read(choice)) {
             continue;
         }
-        
-        if (choice == 1) { 
-            cout << "\n--- ACCOUNT STATUS ---" << endl;
+
+        if (choice == 1) {
+            out << "\n--- ACCOUNT STATUS ---" << endl;
             try {
-                myBank.printCustomerInfo(currentBuyer->getAccount().getId());
+                printCustomerInfo(s.currentBuyer->getAccount().getId(), out);
             } catch (const exception& e) {
                 cerr << "Error fetching bank info: " << e.what() << endl;
             }
-            cout << "Role: " << (isSeller ? "Buyer & Seller (Store: " + currentSeller->sellerName + ")" : "Buyer Only") << endl;
-            cout << "----------------------" << endl;
-        } 
-        else if (choice == 2) { 
+            out << "Role: " << (isSeller ? "Buyer & Seller (Store: " + s.currentSeller->sellerName + ")" : "Buyer Only") << endl;
+            out << "----------------------" << endl;
+        }
+        else if (choice == 2) {
             if (isSeller) {
-                sellerMenu();
+                co_await sellerMenu(s);
             } else {
-                upgradeToSeller();
-                currentSeller = findSeller(currentBuyer->getId()); 
+                co_await upgradeToSeller(s);
+                s.currentSeller = findSeller(s.currentBuyer->getId());
             }
-        } 
-        else if (choice == (2 + offset)) { 
-            cashFlowMenu(currentBuyer->getAccount());
         }
-        else if (choice == (3 + offset)) { 
-            browseStoreFunctionality();
+        else if (choice == (2 + offset)) {
+            co_await cashFlowMenu(s, s.currentBuyer->getAccount());
+        }
+        else if (choice == (3 + offset)) {
+            co_await browseStoreFunctionality(s);
         }
-        else if (choice == (4 + offset)) { 
-            orderFunctionality();
+        else if (choice == (4 + offset)) {
+            co_await orderFunctionality(s);
         }
-        else if (choice == (5 + offset)) { 
+        else if (choice == (5 + offset)) {
             int k;
-            cout << "Enter K (last number of days): ";
-            if (!(cin >> k) || k <= 0) { cout << "Invalid input." << endl; break; }
-            checkSpendingLastKDays(k);
+            out << "Enter K (last number of days): ";
+            if (!co_await s.read(k) || k <= 0) { out << "Invalid input." << endl; break; }
+            checkSpendingLastKDays(*s.currentBuyer, k, out);
         }
-        else if (choice == (6 + offset)) { 
-            cout << "Logging out...\n";
-            currentBuyer = nullptr;
-            currentSeller = nullptr;
-            isLoggedIn = false;
-            return;
+        else if (choice == (6 + offset)) {
+            out << "Logging out...\n";
+            s.currentBuyer = nullptr;
+            s.currentSeller = nullptr;
+            s.isLoggedIn = false;
+            co_return;
         }
-        else if (choice == (7 + offset)) { 
-            cout << "--- DUMMY: Delete Account Functionality ---" << endl;
+        else if (choice == (7 + offset)) {
+            out << "--- DUMMY: Delete Account Functionality ---" << endl;
         }
         else {
-             cout << "Invalid option." << endl;
+             out << "Invalid option." << endl;
         }
 
-    } while (isLoggedIn);
+    } while (s.isLoggedIn);
 }
 
-void sellerMenu() {
-    if (!currentSeller) return;
+Task<> sellerMenu(Session& s) {
+    if (!s.currentSeller) co_return;
 
+    ostream& out = s.out;
     int choice;
     do {
-        cout << "\n--- SELLER MENU (Store: " << currentSeller->sellerName << ") ---" << endl;
-        cout << "9. Item Management (Register/Replenish/Set Price)" << endl;
-        cout << "10. Discover Top K Most Popular Items (Month)" << endl;
-        cout << "11. Discover Loyal Customer (Month)" << endl;
-        cout << "12. View Orders (DUMMY)" << endl;
-        cout << "13. Exit to Buyer Menu" << endl;
-        cout << "14. Exit Program" << endl;
-
-        cout << "Pilihan >> ";
-        if (!(cin >> choice)) {
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        out << "\n--- SELLER MENU (Store: " << s.currentSeller->sellerName << ") ---" << endl;
+        out << "9. Item Management (Register/Replenish/Set Price)" << endl;
+        out << "10. Discover Top K Most Popular Items (Month)" << endl;
+        out << "11. Discover Loyal Customer (Month)" << endl;
+        out << "12. View Orders (DUMMY)" << endl;
+        out << "13. Exit to Buyer Menu" << endl;
+        out << "14. Exit Program" << endl;
+
+        out << "Pilihan >> ";
+        if (!co_await s.read(choice)) {
             continue;
         }
 
         switch (choice) {
             case 9:
-                itemManagementMenu(); 
+                co_await itemManagementMenu(s);
                 break;
             case 10:
-                discoverTopItemsPerMonth();
+                co_await discoverTopItemsPerMonth(s);
                 break;
             case 11:
-                discoverLoyalCustomerPerMonth();
+                discoverLoyalCustomerPerMonth(*s.currentSeller, out);
                 break;
             case 12:
-                cout << "--- DUMMY: View Orders ---" << endl;
+                out << "--- DUMMY: View Orders ---" << endl;
                 break;
-            case 13: 
-                return;
-            case 14: 
-                currentBuyer = nullptr;
-                currentSeller = nullptr;
-                isLoggedIn = false;
-                return; 
+            case 13:
+                co_return;
+            case 14:
+                s.currentBuyer = nullptr;
+                s.currentSeller = nullptr;
+                s.isLoggedIn = false;
+                co_return;
             default:
-                cout << "Invalid option." << endl;
+                out << "Invalid option." << endl;
                 break;
         }
     } while (true);
 }
 
-void upgradeToSeller() {
-    if (!currentBuyer) return;
+Task<> upgradeToSeller(Session& s) {
+    if (!s.currentBuyer) co_return;
 
-    cout << "\n--- SELLER UPGRADE ---" << endl;
+    ostream& out = s.out;
+    out << "\n--- SELLER UPGRADE ---" << endl;
     char confirm;
     string storeName;
-    
-    cout << "Your account is linked with Bank ID: " << currentBuyer->getAccount().getId() << endl;
-    cout << "Confirm upgrade to Seller? (y/n): ";
-    cin >> confirm;
-    
+
+    out << "Your account is linked with Bank ID: " << s.currentBuyer->getAccount().getId() << endl;
+    out << "Confirm upgrade to Seller? (y/n): ";
+    co_await s.read(confirm);
+
     if (tolower(confirm) == 'y') {
-        cout << "Enter New Store Name: "; cin.ignore(); getline(cin, storeName);
-        
-        sellers.emplace_back(*currentBuyer, currentBuyer->getId(), storeName);
-        
-        cout << "\n✅ Successfully upgraded " << currentBuyer->getName() 
+        out << "Enter New Store Name: "; co_await s.readLine(storeName);
+
+        if (!addSeller(*s.currentBuyer, storeName)) {
+            out << "Upgrade failed: " << s.currentBuyer->getName() << " already runs a store.\n";
+            co_return;
+        }
+
+        out << "\n✅ Successfully upgraded " << s.currentBuyer->getName()
              << " to Seller! Store Name: " << storeName << ".\n";
     } else {
-        cout << "Seller upgrade cancelled.\n";
+        out << "Seller upgrade cancelled.\n";
     }
 }
 
 
-void browseStoreFunctionality() {
-    cout << "\n--- BROWSE STORE & ADD TO CART ---" << endl;
+Task<> browseStoreFunctionality(Session& s) {
+    ostream& out = s.out;
+    out << "\n--- BROWSE STORE & ADD TO CART ---" << endl;
     if (sellers.empty()) {
-        cout << "No sellers available." << endl;
-        return;
+        out << "No sellers available." << endl;
+        co_return;
     }
 
     int itemId, qty;
-    Order currentCart(++orderIdCounter, currentBuyer->getId());
+    s.cart.clear();
 
     do {
-        cout << "\nAvailable Items (across all stores):" << endl;
-        cout << "ID | Name | Seller | Price | Stock" << endl;
-        cout << "---|------|--------|-------|------" << endl;
-        int displayCount = 0;
-        for (const auto& s : sellers) {
-            for (const auto& item : s.getItems()) {
-                if (item.isDisplayed()) {
-                    cout << item.getId() << " | " << item.getName() << " | "
-                         << s.sellerName << " | $" << item.getPrice() << " | " 
-                         << item.getQuantity() << endl;
-                    displayCount++;
-                }
-            }
-        }
-        if (displayCount == 0) {
-             cout << "No visible items in any store." << endl;
-             break; 
+        out << "\nAvailable Items (across all stores):" << endl;
+        if (listStoreItems(out) == 0) {
+             out << "No visible items in any store." << endl;
+             break;
         }
 
-        cout << "\nEnter Item ID to add to cart (0 to checkout): ";
-        if (!(cin >> itemId)) { cin.clear(); cin.ignore(numeric_limits<streamsize>::max(), '\n'); continue; }
+        out << "\nEnter Item ID to add to cart (0 to checkout): ";
+        if (!co_await s.read(itemId)) continue;
 
         if (itemId == 0) break;
 
         seller* itemSeller = nullptr;
-        Item* item = findItemInStore(itemId, itemSeller);
+        Item* item = nullptr;
+        string itemName;
+        {
+            shared_lock<shared_mutex> lock(inventoryMutex);
+            item = findItemInStore(itemId, itemSeller);
+            if (item) itemName = item->getName();
+        }
 
         if (item && itemSeller) {
-            cout << "Enter Quantity for " << item->getName() << ": ";
-            if (!(cin >> qty)) { cin.clear(); cin.ignore(numeric_limits<streamsize>::max(), '\n'); continue; }
+            out << "Enter Quantity for " << itemName << ": ";
+            if (!co_await s.read(qty)) continue;
 
+            shared_lock<shared_mutex> lock(inventoryMutex);
             if (qty <= 0) {
-                cout << "Quantity must be positive." << endl;
+                out << "Quantity must be positive." << endl;
             } else if (!item->checkAvailability(qty)) {
-                cout << "Rejected: Insufficient stock. Available: " << item->getQuantity() << endl;
+                out << "Rejected: Insufficient stock. Available: " << item->getQuantity() << endl;
             } else {
-                currentCart.addItem(item->getId(), item->getName(), item->getPrice(), qty, itemSeller->getId());
-                cout << "✅ Added " << qty << "x " << item->getName() << " to cart." << endl;
+                s.cart.push_back({item->getId(), item->getName(), item->getPrice(), qty, itemSeller->getId()});
+                out << "✅ Added " << qty << "x " << item->getName() << " to cart." << endl;
             }
         } else {
-            cout << "Item ID not found." << endl;
+            out << "Item ID not found." << endl;
         }
     } while (true);
 
-    if (currentCart.getTotalAmount() > 0) {
-        cout << "\n--- CHECKOUT REQUIRED ---" << endl;
-        currentCart.printDetails();
-        currentBuyer->getOrders().push_back(currentCart);
-        cout << "Invoice " << currentCart.getId() << " created. Please proceed to Payment Functionality." << endl;
+    if (!s.cart.empty()) {
+        // Numbered only at checkout, so abandoned carts never use up an id.
+        Order invoice(++orderIdCounter, s.currentBuyer->getId());
+        for (const OrderItem& line : s.cart) {
+            invoice.addItem(line.itemId, line.itemName, line.price, line.quantity, line.sellerId);
+        }
+        s.cart.clear();
+        out << "\n--- CHECKOUT REQUIRED ---" << endl;
+        invoice.printDetails(out);
+        s.currentBuyer->addOrder(invoice);
+        out << "Invoice " << invoice.getId() << " created. Please proceed to Payment Functionality." << endl;
     } else {
-        orderIdCounter--;
-        cout << "Cart is empty. Returning to Buyer Menu." << endl;
+        out << "Cart is empty. Returning to Buyer Menu." << endl;
     }
 }
 
-void orderFunctionality() {
-    cout << "\n--- ORDER MANAGEMENT ---" << endl;
-    if (currentBuyer->getOrders().empty()) {
-        cout << "You have no orders." << endl;
-        return;
+Task<> orderFunctionality(Session& s) {
+    ostream& out = s.out;
+    out << "\n--- ORDER MANAGEMENT ---" << endl;
+    bool none;
+    {
+        lock_guard<mutex> lock(s.currentBuyer->getOrdersMutex());
+        none = s.currentBuyer->getOrders().empty();
     }
-
-    int filterChoice;
-    cout << "Filter orders by status:" << endl;
-    cout << "1. All" << endl;
-    cout << "2. PENDING" << endl;
-    cout << "3. PAID" << endl;
-    cout << "4. CANCELED" << endl;
-    cout << "5. COMPLETED" << endl;
-    cout << "Pilihan >> ";
-    if (!(cin >> filterChoice) || filterChoice < 1 || filterChoice > 5) {
-        cout << "Invalid filter choice." << endl; return;
+    if (none) {
+        out << "You have no orders." << endl;
+        co_return;
     }
 
-    cout << "\n--- LISTING ORDERS ---" << endl;
-    for (Order& order : currentBuyer->getOrders()) {
+    int filterChoice;
+    out << "Filter orders by status:" << endl;
+    out << "1. All" << endl;
+    out << "2. PENDING" << endl;
+    out << "3. PAID" << endl;
+    out << "4. CANCELED" << endl;
+    out << "5. COMPLETED" << endl;
+    out << "Pilihan >> ";
+    if (!co_await s.read(filterChoice) || filterChoice < 1 || filterChoice > 5) {
+        out << "Invalid filter choice." << endl; co_return;
+    }
+
+    out << "\n--- LISTING ORDERS ---" << endl;
+    unique_lock<mutex> lock(s.currentBuyer->getOrdersMutex());
+    for (Order& order : s.currentBuyer->getOrders()) {
         bool match = false;
         switch (filterChoice) {
             case 1: match = true; break;
@@ -501,483 +617,336 @@ void orderFunctionality() {
         }
 
         if (match) {
-            order.printDetails();
+            order.printDetails(out);
             if (order.getStatus() == Order::PENDING) {
-                cout << "    [Action: Proceed to Payment]\n";
+                out << "    [Action: Proceed to Payment]\n";
             }
         }
     }
+    lock.unlock();
 
-    paymentFunctionality(); 
+    co_await paymentFunctionality(s);
 }
 
-void paymentFunctionality() {
-    cout << "\n--- PAYMENT FUNCTIONALITY ---" << endl;
+Task<> paymentFunctionality(Session& s) {
+    ostream& out = s.out;
+    out << "\n--- PAYMENT FUNCTIONALITY ---" << endl;
     int invoiceId;
-    cout << "Enter Invoice ID to pay (0 to skip): ";
-    if (!(cin >> invoiceId)) { cin.clear(); cin.ignore(numeric_limits<streamsize>::max(), '\n'); return; }
+    out << "Enter Invoice ID to pay (0 to skip): ";
+    if (!co_await s.read(invoiceId)) co_return;
 
-    if (invoiceId == 0) return;
+    if (invoiceId == 0) co_return;
 
+    // Orders never move, so the invoice can be held across the payment;
+    // claiming it keeps another session of this buyer from paying it too.
+    Buyer& buyer = *s.currentBuyer;
     Order* orderToPay = nullptr;
-    for (Order& order : currentBuyer->getOrders()) {
-        if (order.getId() == invoiceId) {
-            orderToPay = &order;
-            break;
+    {
+        lock_guard<mutex> lock(buyer.getOrdersMutex());
+        for (Order& order : buyer.getOrders()) {
+            if (order.getId() == invoiceId) {
+                orderToPay = &order;
+                break;
+            }
         }
-    }
 
-    if (!orderToPay) {
-        cout << "Invoice ID not found." << endl;
-        return;
-    }
+        if (!orderToPay) {
+            out << "Invoice ID not found." << endl;
+            co_return;
+        }
 
-    if (orderToPay->getStatus() != Order::PENDING) {
-        cout << "Payment rejected: Invoice is already " << orderToPay->getStatusString() << endl;
-        return;
+        if (orderToPay->getStatus() != Order::PENDING) {
+            out << "Payment rejected: Invoice is already " << orderToPay->getStatusString() << endl;
+            co_return;
+        }
+        if (orderToPay->isPaying()) {
+            out << "Payment rejected: Invoice is already being paid." << endl;
+            co_return;
+        }
+        orderToPay->setPaying(true);
     }
 
     double total = orderToPay->getTotalAmount();
-    cout << "Invoice Total: $" << total << endl;
-    cout << "Your Balance: $" << currentBuyer->getAccount().getBalance() << endl;
-    cout << "Processing payment..." << endl;
+    out << "Invoice Total: $" << total << endl;
+    out << "Your Balance: $" << s.currentBuyer->getAccount().getBalance() << endl;
+    out << "Processing payment..." << endl;
 
-    if (!myBank.withdraw(currentBuyer->getAccount().getId(), total)) {
-        cout << "Payment FAILED: Insufficient funds or bank error." << endl;
-        return;
-    }
-
-    orderToPay->markAsPaid();
-    cout << "✅ Order ID " << orderToPay->getId() << " successfully PAID." << endl;
-    
-    map<int, double> sellerPayments; 
-    for (const auto& item : orderToPay->getItems()) {
-        double itemTotal = item.price * item.quantity;
-        sellerPayments[item.sellerId] += itemTotal;
-
-        if (seller* s = findSeller(item.sellerId)) {
-            if (Item* i = s->findItemById(item.itemId)) {
-                i->discard(item.quantity); 
-            }
-        }
+    PaymentResult result = co_await s.pay(paymentEngine(), paymentRequestFor(*orderToPay, buyer));
+    {
+        lock_guard<mutex> lock(buyer.getOrdersMutex());
+        orderToPay->setPaying(false);
+        if (result.status == TransferStatus::OK) orderToPay->markAsPaid();
     }
-
-    for (const auto& pair : sellerPayments) {
-        int sellerId = pair.first;
-        double amount = pair.second;
-        
-        if (seller* s = findSeller(sellerId)) {
-            myBank.deposit(s->getAccount().getId(), amount); 
-            
-            allTransactions.emplace_back(++transactionIdCounter, 
-                                         currentBuyer->getId(), 
-                                         sellerId, 
-                                         "Invoice #" + to_string(orderToPay->getId()) + " (" + to_string(orderToPay->getItems().size()) + " items)", 
-                                         amount);
-            
-            cout << "    - Credited $" << amount << " to Seller ID " << sellerId << " (" << s->sellerName << ")." << endl;
-        }
+    if (result.status != TransferStatus::OK) {
+        out << "Payment FAILED: " << transferStatusString(result.status) << "." << endl;
+        co_return;
     }
-}
-
-void checkSpendingLastKDays(int k) {
-    if (k <= 0) { cout << "K must be positive." << endl; return; }
 
-    auto k_days_ago = chrono::system_clock::now() - chrono::hours(24 * k); 
-    double totalSpending = 0.0;
+    out << "✅ Order ID " << orderToPay->getId() << " successfully PAID." << endl;
 
-    cout << "\n--- SPENDING ANALYSIS (LAST " << k << " DAYS) ---" << endl;
-    for (const auto& flow : cashFlows) {
-        if (flow.getAccountId() == currentBuyer->getAccount().getId() && 
-            flow.getTimestamp() >= k_days_ago && 
-            flow.getType() == "Debit") {
-            
-            totalSpending += flow.getAmount();
-            flow.printInfo(); cout << endl;
-        }
+    for (const auto& credit : result.sellerCredits) {
+        seller* store = findSeller(credit.first);
+        out << "    - Credited $" << credit.second << " to Seller ID " << credit.first
+            << " (" << (store ? store->sellerName : "Unknown") << ")." << endl;
     }
-
-    cout << "---------------------------------------" << endl;
-    cout << "Total Debit Spending: $" << totalSpending << endl;
 }
 
-void cashFlowMenu(BankCustomer& account) {
+Task<> cashFlowMenu(Session& s, BankCustomer& account) {
+    ostream& out = s.out;
     int choice;
     double amount;
     do {
-        cout << "\n--- BANKING MENU (ID: " << account.getId() << ") ---" << endl;
-        cout << "1. Check Balance" << endl;
-        cout << "2. Topup (Deposit)" << endl;
-        cout << "3. Withdraw" << endl;
-        cout << "4. List Cash Flow (Today)" << endl;
-        cout << "5. List Cash Flow (Last Month)" << endl;
-        cout << "6. Back to Buyer Menu" << endl;
-        
-        cout << "Pilihan >> ";
-        if (!(cin >> choice)) {
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        out << "\n--- BANKING MENU (ID: " << account.getId() << ") ---" << endl;
+        out << "1. Check Balance" << endl;
+        out << "2. Topup (Deposit)" << endl;
+        out << "3. Withdraw" << endl;
+        out << "4. List Cash Flow (Today)" << endl;
+        out << "5. List Cash Flow (Last Month)" << endl;
+        out << "6. Back to Buyer Menu" << endl;
+
+        out << "Pilihan >> ";
+        if (!co_await s.read(choice)) {
             continue;
         }
 
         switch (choice) {
-            case 1: 
-                cout << "Current Balance: $" << account.getBalance() << endl;
+            case 1:
+                out << "Current Balance: $" << account.getBalance() << endl;
                 break;
-            case 2: 
-                cout << "Enter amount to topup: $"; 
-                if (!(cin >> amount) || amount <= 0) { cout << "Invalid amount." << endl; break; }
-                myBank.deposit(account.getId(), amount);
+            case 2:
+                out << "Enter amount to topup: $";
+                if (!co_await s.read(amount) || amount <= 0) { out << "Invalid amount." << endl; break; }
+                printBalanceChange("Deposit", myBank.deposit(account.getId(), amount), &account, out);
                 break;
-            case 3: 
-                cout << "Enter amount to withdraw: $";
-                if (!(cin >> amount) || amount <= 0) { cout << "Invalid amount." << endl; break; }
-                myBank.withdraw(account.getId(), amount);
+            case 3:
+                out << "Enter amount to withdraw: $";
+                if (!co_await s.read(amount) || amount <= 0) { out << "Invalid amount." << endl; break; }
+                printBalanceChange("Withdraw", myBank.withdraw(account.getId(), amount), &account, out);
                 break;
-            case 4: 
-                {
-                    time_t now_t = chrono::system_clock::to_time_t(chrono::system_clock::now());
-                    struct tm *ltm = localtime(&now_t);
-                    ltm->tm_hour = 0; ltm->tm_min = 0; ltm->tm_sec = 0;
-                    auto today_start = chrono::system_clock::from_time_t(mktime(ltm));
-
-                    cout << "\n--- CASH FLOW: TODAY ---" << endl;
-                    int count = 0;
-                    for(const auto& flow : cashFlows) {
-                        if (flow.getAccountId() == account.getId() && flow.getTimestamp() >= today_start) {
-                            flow.printInfo(); cout << endl;
-                            count++;
-                        }
-                    }
-                    if (count == 0) cout << "No cash flow recorded today." << endl;
-                    cout << "------------------------" << endl;
-                }
+            case 4:
+                listCashFlowToday(account, out);
                 break;
-            case 5: 
-                {
-                    auto month_ago = chrono::system_clock::now() - chrono::hours(24 * 30);
-                    cout << "\n--- CASH FLOW: LAST MONTH ---" << endl;
-                    int count = 0;
-                    for(const auto& flow : cashFlows) {
-                        if (flow.getAccountId() == account.getId() && flow.getTimestamp() >= month_ago) {
-                            flow.printInfo(); cout << endl;
-                            count++;
-                        }
-                    }
-                    if (count == 0) cout << "No cash flow recorded in the last month." << endl;
-                    cout << "-----------------------------" << endl;
-                }
+            case 5:
+                listCashFlowLastMonth(account, out);
                 break;
-            case 6: 
-                return;
+            case 6:
+                co_return;
             default:
-                cout << "Invalid option." << endl;
+                out << "Invalid option." << endl;
                 break;
         }
     } while (true);
 }
 
 
-void itemManagementMenu() {
-    cout << "\n--- ITEM MANAGEMENT (Store: " << currentSeller->sellerName << ") ---" << endl;
+Task<> itemManagementMenu(Session& s) {
+    ostream& out = s.out;
+    seller* store = s.currentSeller;
+    out << "\n--- ITEM MANAGEMENT (Store: " << store->sellerName << ") ---" << endl;
     int choice;
-    
-    cout << "\n--- Current Inventory ---" << endl;
-    cout << "ID | Name | Price | Stock" << endl;
-    cout << "---|------|-------|------" << endl;
-    for (const auto& item : currentSeller->items) {
-        cout << item.getId() << " | " << item.getName() << " | $" << item.getPrice() << " | " << item.getQuantity() << endl;
+
+    out << "\n--- Current Inventory ---" << endl;
+    out << "ID | Name | Price | Stock" << endl;
+    out << "---|------|-------|------" << endl;
+    {
+        shared_lock<shared_mutex> lock(inventoryMutex);
+        for (const auto& item : store->items) {
+            out << item.getId() << " | " << item.getName() << " | $" << item.getPrice() << " | " << item.getQuantity() << endl;
+        }
     }
 
-    cout << "\nSelect Action:" << endl;
-    cout << "1. Register New Item" << endl;
-    cout << "2. Replenish (Add Stock)" << endl;
-    cout << "3. Discard (Remove Stock)" << endl;
-    cout << "4. Set Price" << endl;
-    cout << "5. Back to Seller Menu" << endl;
+    out << "\nSelect Action:" << endl;
+    out << "1. Register New Item" << endl;
+    out << "2. Replenish (Add Stock)" << endl;
+    out << "3. Discard (Remove Stock)" << endl;
+    out << "4. Set Price" << endl;
+    out << "5. Bulk Import from File (CSV or binary)" << endl;
+    out << "6. Back to Seller Menu" << endl;
 
-    cout << "Pilihan >> ";
-    if (!(cin >> choice)) { cin.clear(); cin.ignore(numeric_limits<streamsize>::max(), '\n'); return; }
+    out << "Pilihan >> ";
+    if (!co_await s.read(choice)) co_return;
 
     int itemId, amount;
     double price;
     string name;
 
     switch (choice) {
-        case 1: 
-            cout << "Enter Item Name: "; cin.ignore(); getline(cin, name);
-            cout << "Enter Initial Quantity: "; 
-            if (!(cin >> amount) || amount <= 0) { cout << "Invalid quantity." << endl; break; }
-            cout << "Enter Price: $"; 
-            if (!(cin >> price) || price <= 0) { cout << "Invalid price." << endl; break; }
-            currentSeller->addNewItem(++itemIdCounter, name, amount, price);
-            currentSeller->makeItemVisibleToCustomer(itemIdCounter);
-            cout << "✅ Item '" << name << "' added with ID: " << itemIdCounter << endl;
+        case 1:
+            out << "Enter Item Name: "; co_await s.readLine(name);
+            out << "Enter Initial Quantity: ";
+            if (!co_await s.read(amount) || amount <= 0) { out << "Invalid quantity." << endl; break; }
+            out << "Enter Price: $";
+            if (!co_await s.read(price) || price <= 0) { out << "Invalid price." << endl; break; }
+            {
+                unique_lock<shared_mutex> lock(inventoryMutex);
+                int newId = addStoreItem(*store, name, amount, price);
+                out << "✅ Item '" << name << "' added with ID: " << newId << endl;
+            }
             break;
-        case 2: 
-            cout << "Enter Item ID to replenish: "; 
-            if (!(cin >> itemId)) break;
-            cout << "Enter amount to add: "; 
-            if (!(cin >> amount) || amount <= 0) { cout << "Invalid amount." << endl; break; }
-            if (currentSeller->replenishItem(itemId, amount)) {
-                cout << "✅ Replenished " << amount << " units to Item ID " << itemId << endl;
-            } else { cout << "Item ID not found." << endl; }
+        case 2:
+            out << "Enter Item ID to replenish: ";
+            if (!co_await s.read(itemId)) break;
+            out << "Enter amount to add: ";
+            if (!co_await s.read(amount) || amount <= 0) { out << "Invalid amount." << endl; break; }
+            {
+                unique_lock<shared_mutex> lock(inventoryMutex);
+                if (store->replenishItem(itemId, amount)) {
+                    out << "✅ Replenished " << amount << " units to Item ID " << itemId << endl;
+                } else { out << "Item ID not found." << endl; }
+            }
             break;
-        case 3: 
-            cout << "Enter Item ID to discard: "; 
-            if (!(cin >> itemId)) break;
-            cout << "Enter amount to discard: "; 
-            if (!(cin >> amount) || amount <= 0) { cout << "Invalid amount." << endl; break; }
-            if (currentSeller->discardItem(itemId, amount)) {
-                cout << "✅ Discarded " << amount << " units from Item ID " << itemId << endl;
-            } else { cout << "Discard failed (Insufficient stock or Item ID not found)." << endl; }
+        case 3:
+            out << "Enter Item ID to discard: ";
+            if (!co_await s.read(itemId)) break;
+            out << "Enter amount to discard: ";
+            if (!co_await s.read(amount) || amount <= 0) { out << "Invalid amount." << endl; break; }
+            {
+                unique_lock<shared_mutex> lock(inventoryMutex);
+                if (store->discardItem(itemId, amount)) {
+                    out << "✅ Discarded " << amount << " units from Item ID " << itemId << endl;
+                } else { out << "Discard failed (Insufficient stock or Item ID not found)." << endl; }
+            }
             break;
-        case 4: 
-            cout << "Enter Item ID to set price: "; 
-            if (!(cin >> itemId)) break;
-            cout << "Enter new price: $"; 
-            if (!(cin >> price) || price <= 0) { cout << "Invalid price." << endl; break; }
-            currentSeller->setItemPrice(itemId, price);
-            cout << "✅ Price for Item ID " << itemId << " set to $" << price << endl;
+        case 4:
+            out << "Enter Item ID to set price: ";
+            if (!co_await s.read(itemId)) break;
+            out << "Enter new price: $";
+            if (!co_await s.read(price) || price <= 0) { out << "Invalid price." << endl; break; }
+            {
+                unique_lock<shared_mutex> lock(inventoryMutex);
+                store->setItemPrice(itemId, price);
+            }
+            out << "✅ Price for Item ID " << itemId << " set to $" << price << endl;
+            break;
+        case 5:
+            out << "Enter file path: "; co_await s.readLine(name);
+            {
+                ifstream file(name, ios::binary);
+                if (!file) { out << "Cannot open " << name << endl; break; }
+                ImportResult result = importInventory(*store, file);
+                out << "✅ Imported " << result.imported << " items";
+                if (result.imported > 0) out << " (IDs " << result.firstId << "-" << result.lastId << ")";
+                out << " in " << result.seconds << " s" << endl;
+                if (result.rejected > 0) {
+                    out << "Skipped " << result.rejected << " invalid rows (first at row " << result.firstRejectedRow << ")." << endl;
+                }
+                if (!result.error.empty()) out << "Import stopped: " << result.error << endl;
+            }
             break;
         default:
             break;
     }
 }
 
-void discoverTopItemsPerMonth() {
+Task<> discoverTopItemsPerMonth(Session& s) {
+    ostream& out = s.out;
     int k;
-    cout << "Enter K (Top number of items): ";
-    if (!(cin >> k) || k <= 0) { cout << "Invalid input." << endl; return; }
-
-    auto month_ago = chrono::system_clock::now() - chrono::hours(24 * 30);
-    map<string, int> itemSaleCounts;
-
-    for (const auto& t : allTransactions) {
-        if (t.getTimestamp() >= month_ago && t.getSellerId() == currentSeller->getId()) {
-            itemSaleCounts[t.getItemName()]++;
-        }
-    }
+    out << "Enter K (Top number of items): ";
+    if (!co_await s.read(k) || k <= 0) { out << "Invalid input." << endl; co_return; }
 
-    vector<pair<int, string>> sortedItems;
-    for (const auto& pair : itemSaleCounts) {
-        sortedItems.push_back({pair.second, pair.first});
-    }
-
-    sort(sortedItems.rbegin(), sortedItems.rend());
-
-    cout << "\n--- TOP " << k << " POPULAR ITEMS (LAST MONTH) ---" << endl;
-    if (sortedItems.empty()) { cout << "No sales data found this month." << endl; return; }
-    
-    for (int i = 0; i < min((int)sortedItems.size(), k); ++i) {
-        cout << i + 1 << ". " << sortedItems[i].second 
-             << " (" << sortedItems[i].first << " transactions)" << endl;
-    }
-    cout << "------------------------------------------------" << endl;
+    discoverTopItemsPerMonth(*s.currentSeller, k, out);
 }
 
-void discoverLoyalCustomerPerMonth() {
-    auto month_ago = chrono::system_clock::now() - chrono::hours(24 * 30);
-    map<int, int> buyerTransactionCounts;
-
-    for (const auto& t : allTransactions) {
-        if (t.getTimestamp() >= month_ago && t.getSellerId() == currentSeller->getId()) {
-            buyerTransactionCounts[t.getBuyerId()]++;
-        }
-    }
-
-    vector<pair<int, int>> sortedBuyers; 
-    for (const auto& pair : buyerTransactionCounts) {
-        sortedBuyers.push_back({pair.second, pair.first});
-    }
-
-    sort(sortedBuyers.rbegin(), sortedBuyers.rend());
-
-    cout << "\n--- LOYAL CUSTOMERS (LAST MONTH) ---" << endl;
-    if (sortedBuyers.empty()) { cout << "No loyal customers found this month." << endl; return; }
 
-    for (int i = 0; i < min((int)sortedBuyers.size(), 5); ++i) {
-        int buyerId = sortedBuyers[i].second;
-        int count = sortedBuyers[i].first;
-        
-        string name = "Unknown";
-        if (Buyer* b = findBuyer(buyerId)) { name = b->getName(); }
-
-        cout << i + 1 << ". ID " << buyerId << " (" << name << ") - " 
-             << count << " total orders" << endl;
-    }
-    cout << "-------------------------------------" << endl;
-}
-
-
-void storeCapabilitiesMenu() {
+Task<> storeCapabilitiesMenu(Session& s) {
+    ostream& out = s.out;
     int choice;
     do {
-        cout << "\n--- STORE CAPABILITIES ---" << endl;
-        cout << "1. List all transaction of the latest K days" << endl; 
-        cout << "2. List all paid transaction but yet to be completed" << endl;
-        cout << "3. List all most M frequent item transactions" << endl;
-        cout << "4. List all most active buyer (by total transactions)" << endl;
-        cout << "5. List all most active sellers (by total transactions)" << endl;
-        cout << "6. Back to Main Menu" << endl;
-        
-        cout << "Pilihan >> ";
-        if (!(cin >> choice)) { cin.clear(); cin.ignore(numeric_limits<streamsize>::max(), '\n'); continue; }
-        
+        out << "\n--- STORE CAPABILITIES ---" << endl;
+        out << "1. List all transaction of the latest K days" << endl;
+        out << "2. List all paid transaction but yet to be completed" << endl;
+        out << "3. List all most M frequent item transactions" << endl;
+        out << "4. List all most active buyer (by total transactions)" << endl;
+        out << "5. List all most active sellers (by total transactions)" << endl;
+        out << "6. Toggle Approximate Mode (currently " << (approximateAnalytics ? "ON" : "OFF") << ")" << endl;
+        out << "7. Payment Pipeline Statistics" << endl;
+        out << "8. Back to Main Menu" << endl;
+
+        out << "Pilihan >> ";
+        if (!co_await s.read(choice)) continue;
+        // Ledger writes are applied asynchronously; make ours visible first.
+        syncLedger();
+
         int k, m;
         switch (choice) {
             case 1:
-                cout << "Enter K (number of latest days, 7 for a week): "; 
-                if (!(cin >> k) || k <= 0) { cout << "Invalid input." << endl; break; }
-                listRecentTransactions(k);
+                out << "Enter K (number of latest days, 7 for a week): ";
+                if (!co_await s.read(k) || k <= 0) { out << "Invalid input." << endl; break; }
+                listRecentTransactions(k, out);
                 break;
             case 2:
-                listUncompletedTransactions();
+                listUncompletedTransactions(out);
                 break;
             case 3:
-                cout << "Enter M (number of top items): "; 
-                if (!(cin >> m) || m <= 0) { cout << "Invalid input." << endl; break; }
-                listMostFrequentItems(m);
+                out << "Enter M (number of top items): ";
+                if (!co_await s.read(m) || m <= 0) { out << "Invalid input." << endl; break; }
+                listMostFrequentItems(m, out);
                 break;
             case 4:
-                listMostActiveBuyers();
+                listMostActiveBuyers(out);
                 break;
             case 5:
-                listMostActiveSellers();
+                listMostActiveSellers(out);
                 break;
             case 6:
-                return;
+                approximateAnalytics = !approximateAnalytics;
+                out << "Approximate mode " << (approximateAnalytics ? "enabled" : "disabled") << "." << endl;
+                break;
+            case 7:
+                showPaymentStats(out);
+                break;
+            case 8:
+                co_return;
             default:
-                cout << "Invalid option." << endl;
+                out << "Invalid option." << endl;
         }
     } while (true);
 }
 
-void bankAnalysisMenu() {
+Task<> bankAnalysisMenu(Session& s) {
+    ostream& out = s.out;
     int choice;
     do {
-        cout << "\n--- BANK ANALYSIS ---" << endl;
-        cout << "1. List all transaction within a week (7 days)" << endl;
-        cout << "2. List all bank customers" << endl;
-        cout << "3. List all dormant accounts (no activity within a month)" << endl;
-        cout << "4. List N top users that conduct most transaction for today" << endl;
-        cout << "5. Back to Main Menu" << endl;
-
-        cout << "Pilihan >> ";
-        if (!(cin >> choice)) { cin.clear(); cin.ignore(numeric_limits<streamsize>::max(), '\n'); continue; }
-        
+        out << "\n--- BANK ANALYSIS ---" << endl;
+        out << "1. List all transaction within a week (7 days)" << endl;
+        out << "2. List all bank customers" << endl;
+        out << "3. List all dormant accounts (no activity within a month)" << endl;
+        out << "4. List N top users that conduct most transaction for today" << endl;
+        out << "5. Hot-path metrics (call counts and latencies)" << endl;
+        out << "6. Memory usage by subsystem" << endl;
+        out << "7. Back to Main Menu" << endl;
+
+        out << "Pilihan >> ";
+        if (!co_await s.read(choice)) continue;
+        // Ledger writes are applied asynchronously; make ours visible first.
+        syncLedger();
+
         int n;
         switch (choice) {
             case 1:
-                listRecentTransactions(7); 
+                listRecentTransactions(7, out);
                 break;
             case 2:
-                myBank.listAllCustomers();
+                listAllCustomers(out);
                 break;
             case 3:
-                myBank.listDormantAccounts();
+                listDormantAccounts(out);
                 break;
             case 4:
-                cout << "Enter N (number of top users): "; 
-                if (!(cin >> n) || n <= 0) { cout << "Invalid input." << endl; break; }
-                myBank.listTopUsersToday(n);
+                out << "Enter N (number of top users): ";
+                if (!co_await s.read(n) || n <= 0) { out << "Invalid input." << endl; break; }
+                listTopUsersToday(n, out);
                 break;
             case 5:
-                return;
+                printMetrics(out);
+                break;
+            case 6:
+                printMemoryReport(out);
+                break;
+            case 7:
+                co_return;
             default:
-                cout << "Invalid option." << endl;
+                out << "Invalid option." << endl;
         }
     } while (true);
 }
-
-void listRecentTransactions(int k) {
-    if (k <= 0) { cout << "K must be positive." << endl; return; }
-
-    auto k_days_ago = chrono::system_clock::now() - chrono::hours(24 * k); 
-
-    cout << "\n--- TRANSACTIONS OF LAST " << k << " DAYS ---" << endl;
-    int count = 0;
-    for (const auto& t : allTransactions) {
-        if (t.getTimestamp() >= k_days_ago) {
-            cout << "ID: " << t.getId() 
-                 << ", Buyer: " << t.getBuyerId() 
-                 << ", Seller: " << t.getSellerId()
-                 << ", Item: " << t.getItemName()
-                 << ", Amount: $" << t.getAmount()
-                 << ", Status: " << t.getStatusString() << endl;
-            count++;
-        }
-    }
-    if (count == 0) cout << "No transactions found in the last " << k << " days." << endl;
-}
-
-void listUncompletedTransactions() {
-    cout << "\n--- PAID BUT UNCOMPLETED TRANSACTIONS ---" << endl;
-    int count = 0;
-    for (const auto& t : allTransactions) {
-        if (t.getStatus() == Transaction::PAID) {
-             cout << "ID: " << t.getId() 
-                 << ", Buyer: " << t.getBuyerId() 
-                 << ", Seller: " << t.getSellerId()
-                 << ", Item: " << t.getItemName()
-                 << ", Amount: $" << t.getAmount()
-                 << endl;
-            count++;
-        }
-    }
-    if (count == 0) cout << "No uncompleted transactions found." << endl;
-}
-
-void listMostFrequentItems(int m) {
-    map<string, int> itemCounts;
-    for (const auto& t : allTransactions) {
-        itemCounts[t.getItemName()]++;
-    }
-
-    vector<pair<int, string>> sortedItems;
-    for (const auto& pair : itemCounts) {
-        sortedItems.push_back({pair.second, pair.first});
-    }
-
-    sort(sortedItems.rbegin(), sortedItems.rend());
-
-    cout << "\n--- TOP " << m << " MOST FREQUENT ITEMS (All Time) ---" << endl;
-    for (int i = 0; i < min((int)sortedItems.size(), m); ++i) {
-        cout << i + 1 << ". " << sortedItems[i].second 
-             << " (" << sortedItems[i].first << " transactions)" << endl;
-    }
-}
-
-void listMostActiveUsers(const string& type, int (Transaction::*getIdFunc)() const) {
-    map<int, int> userCounts;
-    for (const auto& t : allTransactions) {
-        userCounts[(t.*getIdFunc)()]++;
-    }
-
-    vector<pair<int, int>> sortedUsers;
-    for (const auto& pair : userCounts) {
-        sortedUsers.push_back({pair.second, pair.first}); 
-    }
-
-    sort(sortedUsers.rbegin(), sortedUsers.rend());
-
-    cout << "\n--- MOST ACTIVE " << type << " (Total Transactions) ---" << endl;
-    for (int i = 0; i < min((int)sortedUsers.size(), 5); ++i) { 
-        int userId = sortedUsers[i].second;
-        int count = sortedUsers[i].first;
-
-        string name = "Unknown";
-        if (Buyer* b = findBuyer(userId)) { name = b->getName(); }
-
-        cout << i + 1 << ". ID " << userId << " (" << name << ") - " 
-             << count << " transactions\n";
-    }
-}
-
-void listMostActiveBuyers() {
-    listMostActiveUsers("BUYERS", &Transaction::getBuyerId);
-}
-
-void listMostActiveSellers() {
-    listMostActiveUsers("SELLERS", &Transaction::getSellerId);
-}
@@ -0,0 +1,108 @@
+#include "memory_accounting.h"
+
+#include <iomanip>
+
+using namespace std;
+
+namespace {
+
+constexpr array<const char*, kMemoryTagCount> kTagNames = {
+    "accounts",
+    "contacts",
+    "buyers",
+    "sellers",
+    "inventory",
+    "orders",
+    "transactions",
+    "cash_flows",
+    "ledger_columns",
+};
+
+array<TrackedResource*, kMemoryTagCount>& resources() {
+    // Never destroyed: global logs and containers free through these
+    // during static destruction.
+    static array<TrackedResource*, kMemoryTagCount>* all = [] {
+        auto* made = new array<TrackedResource*, kMemoryTagCount>;
+        for (size_t t = 0; t < kMemoryTagCount; ++t) {
+            (*made)[t] = new TrackedResource(kTagNames[t], pmr::new_delete_resource());
+        }
+        return made;
+    }();
+    return *all;
+}
+
+double mebibytes(int64_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); }
+
+} // namespace
+
+void* TrackedResource::do_allocate(size_t bytes, size_t alignment) {
+    void* p = upstream->allocate(bytes, alignment);
+    auto size = static_cast<int64_t>(bytes);
+    int64_t now = live.fetch_add(size, memory_order_relaxed) + size;
+    int64_t high = peak.load(memory_order_relaxed);
+    while (now > high && !peak.compare_exchange_weak(high, now, memory_order_relaxed)) {
+    }
+    allocations.fetch_add(1, memory_order_relaxed);
+    allocatedBytes.fetch_add(bytes, memory_order_relaxed);
+    return p;
+}
+
+void TrackedResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    upstream->deallocate(p, bytes, alignment);
+    live.fetch_sub(static_cast<int64_t>(bytes), memory_order_relaxed);
+    deallocations.fetch_add(1, memory_order_relaxed);
+}
+
+MemoryUsage TrackedResource::usage() const {
+    return {name,
+            live.load(memory_order_relaxed),
+            peak.load(memory_order_relaxed),
+            allocations.load(memory_order_relaxed),
+            deallocations.load(memory_order_relaxed),
+            allocatedBytes.load(memory_order_relaxed)};
+}
+
+pmr::memory_resource* memoryResource(MemoryTag tag) { return resources()[static_cast<size_t>(tag)]; }
+
+array<MemoryUsage, kMemoryTagCount> memoryUsage() {
+    array<MemoryUsage, kMemoryTagCount> usage;
+    for (size_t t = 0; t < kMemoryTagCount; ++t) usage[t] = resources()[t]->usage();
+    return usage;
+}
+
+void printMemoryReport(ostream& out) {
+    ios_base::fmtflags flags = out.flags();
+    streamsize precision = out.precision();
+
+    out << "\n--- MEMORY BY SUBSYSTEM ---" << endl;
+    out << left << setw(16) << "Subsystem" << right << setw(12) << "Live MiB" << setw(12) << "Peak MiB"
+        << setw(14) << "Allocations" << setw(14) << "Live blocks" << endl;
+    out << fixed << setprecision(2);
+    int64_t live = 0;
+    uint64_t allocations = 0, blocks = 0;
+    for (const MemoryUsage& u : memoryUsage()) {
+        uint64_t held = u.allocations - u.deallocations;
+        out << left << setw(16) << u.subsystem << right << setw(12) << mebibytes(u.liveBytes) << setw(12)
+            << mebibytes(u.peakBytes) << setw(14) << u.allocations << setw(14) << held << endl;
+        live += u.liveBytes;
+        allocations += u.allocations;
+        blocks += held;
+    }
+    out << left << setw(16) << "total" << right << setw(12) << mebibytes(live) << setw(12) << "" << setw(14)
+        << allocations << setw(14) << blocks << endl;
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+void dumpMemoryUsage(ostream& out) {
+    out << "{";
+    bool first = true;
+    for (const MemoryUsage& u : memoryUsage()) {
+        out << (first ? "" : ",") << "\"" << u.subsystem << "\":{\"live_bytes\":" << u.liveBytes
+            << ",\"peak_bytes\":" << u.peakBytes << ",\"allocations\":" << u.allocations
+            << ",\"deallocations\":" << u.deallocations << ",\"allocated_bytes\":" << u.allocatedBytes << "}";
+        first = false;
+    }
+    out << "}\n";
+}
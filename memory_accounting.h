@@ -0,0 +1,87 @@
+#ifndef MEMORY_ACCOUNTING_H
+#define MEMORY_ACCOUNTING_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <ostream>
+
+// Heap usage per subsystem.
+//
+// Each subsystem allocates through its own memoryResource(tag), a
+// std::pmr::memory_resource that forwards to new/delete and counts live
+// bytes, allocations and the high-water mark on the way. Containers take
+// it as their pmr allocator; AppendLog takes it for its chunks.
+//
+// What is counted, per tag:
+//   ACCOUNTS        the bank's account records
+//   CONTACTS        customers' address/email text and the email and phone
+//                   indexes
+//   BUYERS          buyer records
+//   SELLERS         seller records, including the Buyer part each copies
+//   INVENTORY       each seller's item list and id index, and the store's
+//                   item -> seller table
+//   ORDERS          buyers' invoice lists and their line items
+//   TRANSACTIONS    transaction records
+//   CASH_FLOWS      cash-flow records and their type/description text
+//   LEDGER_COLUMNS  the columnar copies scanned by reports
+// Strings inside records are counted only where noted (cash flows); the
+// rest stay with the default heap.
+enum class MemoryTag : unsigned char {
+    ACCOUNTS,
+    CONTACTS,
+    BUYERS,
+    SELLERS,
+    INVENTORY,
+    ORDERS,
+    TRANSACTIONS,
+    CASH_FLOWS,
+    LEDGER_COLUMNS,
+    COUNT
+};
+
+inline constexpr std::size_t kMemoryTagCount = static_cast<std::size_t>(MemoryTag::COUNT);
+
+struct MemoryUsage {
+    const char* subsystem;
+    std::int64_t liveBytes;
+    std::int64_t peakBytes;
+    std::uint64_t allocations;     // since start
+    std::uint64_t deallocations;
+    std::uint64_t allocatedBytes;  // since start, for per-operation deltas
+};
+
+class TrackedResource : public std::pmr::memory_resource {
+private:
+    const char* name;
+    std::pmr::memory_resource* upstream;
+    alignas(64) std::atomic<std::int64_t> live{0};
+    std::atomic<std::int64_t> peak{0};
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> deallocations{0};
+    std::atomic<std::uint64_t> allocatedBytes{0};
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+public:
+    TrackedResource(const char* name, std::pmr::memory_resource* upstream) : name(name), upstream(upstream) {}
+
+    MemoryUsage usage() const;
+};
+
+// Lives until exit, so global containers may free through it last.
+std::pmr::memory_resource* memoryResource(MemoryTag tag);
+
+std::array<MemoryUsage, kMemoryTagCount> memoryUsage();
+
+// The admin table: live, peak and counts per subsystem, with totals.
+void printMemoryReport(std::ostream& out);
+// The same figures as one JSON object, for scripts and deployment sizing.
+void dumpMemoryUsage(std::ostream& out);
+
+#endif // MEMORY_ACCOUNTING_H
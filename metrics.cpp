@@ -0,0 +1,232 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+constexpr array<const char*, kMetricCount> kMetricNames = {
+    "bank.deposit",
+    "bank.withdraw",
+    "bank.transfer",
+    "payment",
+    "store.find_item",
+    "report.store_items",
+    "report.spending",
+    "report.cash_flow",
+    "report.top_items",
+    "report.loyal_customers",
+    "report.customers",
+    "report.dormant",
+    "report.top_users",
+    "report.recent",
+    "report.uncompleted",
+    "report.frequent_items",
+    "report.active_buyers",
+    "report.active_sellers",
+};
+
+constexpr array<const char*, kCounterCount> kCounterNames = {
+    "withdraw.declined",
+    "payment.declined",
+    "store.item_not_found",
+};
+
+// Every block ever handed out, and those whose thread has exited.
+struct Registry {
+    mutex lock;
+    vector<ThreadMetrics*> all;
+    vector<ThreadMetrics*> idle;
+};
+
+Registry& registry() {
+    // Never destroyed: threads may still record during static destruction.
+    static Registry* instance = new Registry;
+    return *instance;
+}
+
+// Returns the thread's block to the idle list when the thread exits.
+struct Lease {
+    ThreadMetrics* block = nullptr;
+
+    ~Lease() {
+        if (!block) return;
+        currentThreadMetrics = nullptr;
+        Registry& r = registry();
+        lock_guard<mutex> guard(r.lock);
+        r.idle.push_back(block);
+    }
+};
+
+thread_local Lease lease;
+
+double micros(uint64_t nanos) { return static_cast<double>(nanos) / 1000.0; }
+
+class Dumper {
+private:
+    mutex lock;
+    condition_variable wake;
+    bool stopping = false;
+    string path;
+    thread worker;
+
+    bool write() {
+        string temp = path + ".tmp";
+        {
+            ofstream file(temp, ios::trunc);
+            time_t now = time(nullptr);
+            struct tm local;
+            localtime_r(&now, &local);
+            char stamp[32];
+            strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &local);
+            file << "# metrics at " << stamp << "\n";
+            printMetrics(file);
+            if (!file) return false;
+        }
+        return rename(temp.c_str(), path.c_str()) == 0;
+    }
+
+public:
+    ~Dumper() { stop(); }
+
+    bool start(const string& target, chrono::seconds interval) {
+        stop();
+        path = target;
+        if (!write()) return false;
+        stopping = false;
+        worker = thread([this, interval] {
+            unique_lock<mutex> guard(lock);
+            while (!wake.wait_for(guard, interval, [this] { return stopping; })) write();
+            write();
+        });
+        return true;
+    }
+
+    void stop() {
+        if (!worker.joinable()) return;
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+};
+
+Dumper dumper;
+
+} // namespace
+
+ThreadMetrics& attachThreadMetrics() {
+    Registry& r = registry();
+    {
+        lock_guard<mutex> guard(r.lock);
+        if (r.idle.empty()) {
+            r.all.push_back(new ThreadMetrics);
+            lease.block = r.all.back();
+        } else {
+            lease.block = r.idle.back();
+            r.idle.pop_back();
+        }
+    }
+    currentThreadMetrics = lease.block;
+    return *lease.block;
+}
+
+void recordLatency(Metric metric, chrono::nanoseconds elapsed) {
+    MetricSlot& slot = threadMetrics().metrics[static_cast<size_t>(metric)];
+    auto nanos = static_cast<uint64_t>(max<int64_t>(elapsed.count(), 0));
+    bumpRelaxed(slot.calls);
+    bumpRelaxed(slot.timed);
+    bumpRelaxed(slot.totalNanos, nanos);
+    if (nanos > slot.maxNanos.load(memory_order_relaxed)) slot.maxNanos.store(nanos, memory_order_relaxed);
+    slot.nanos.record(nanos);
+}
+
+MetricTimer::~MetricTimer() {
+    if (!slot) return;
+    auto nanos = static_cast<uint64_t>(
+        chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - started).count());
+    bumpRelaxed(slot->timed);
+    bumpRelaxed(slot->totalNanos, nanos);
+    if (nanos > slot->maxNanos.load(memory_order_relaxed)) slot->maxNanos.store(nanos, memory_order_relaxed);
+    slot->nanos.record(nanos);
+}
+
+MetricsSnapshot collectMetrics() {
+    vector<ThreadMetrics*> blocks;
+    {
+        Registry& r = registry();
+        lock_guard<mutex> guard(r.lock);
+        blocks = r.all;
+    }
+
+    MetricsSnapshot snapshot{};
+    snapshot.threads = blocks.size();
+    for (size_t m = 0; m < kMetricCount; ++m) {
+        LatencyHistogram merged;
+        uint64_t calls = 0, timed = 0, total = 0, longest = 0;
+        for (const ThreadMetrics* block : blocks) {
+            const MetricSlot& slot = block->metrics[m];
+            calls += slot.calls.load(memory_order_relaxed);
+            timed += slot.timed.load(memory_order_relaxed);
+            total += slot.totalNanos.load(memory_order_relaxed);
+            longest = max(longest, slot.maxNanos.load(memory_order_relaxed));
+            merged.merge(slot.nanos);
+        }
+        snapshot.metrics[m] = {kMetricNames[m],
+                               calls,
+                               timed,
+                               timed ? micros(total) / static_cast<double>(timed) : 0.0,
+                               micros(min(merged.percentile(0.50), longest)),
+                               micros(min(merged.percentile(0.99), longest)),
+                               micros(min(merged.percentile(0.999), longest)),
+                               micros(longest)};
+    }
+    for (size_t c = 0; c < kCounterCount; ++c) {
+        uint64_t total = 0;
+        for (const ThreadMetrics* block : blocks) total += block->counters[c].load(memory_order_relaxed);
+        snapshot.counters[c] = total;
+    }
+    return snapshot;
+}
+
+void printMetrics(ostream& out) {
+    MetricsSnapshot snapshot = collectMetrics();
+    ios_base::fmtflags flags = out.flags();
+    streamsize precision = out.precision();
+
+    out << left << setw(22) << "Metric" << right << setw(10) << "Calls" << setw(10) << "Timed" << setw(10)
+        << "Mean us" << setw(10) << "p50 us" << setw(10) << "p99 us" << setw(11) << "p99.9 us" << setw(10)
+        << "Max us" << "\n";
+    out << fixed << setprecision(1);
+    for (const MetricSummary& m : snapshot.metrics) {
+        if (m.calls == 0) continue;
+        out << left << setw(22) << m.name << right << setw(10) << m.calls << setw(10) << m.timed << setw(10)
+            << m.meanMicros << setw(10) << m.p50Micros << setw(10) << m.p99Micros << setw(11) << m.p999Micros
+            << setw(10) << m.maxMicros << "\n";
+    }
+    for (size_t c = 0; c < kCounterCount; ++c) {
+        if (snapshot.counters[c] == 0) continue;
+        out << left << setw(22) << kCounterNames[c] << right << setw(10) << snapshot.counters[c] << "\n";
+    }
+    out << "Threads recorded: " << snapshot.threads << "\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+bool startMetricsDump(const string& path, chrono::seconds interval) {
+    return dumper.start(path, max(interval, chrono::seconds(1)));
+}
+
+void stopMetricsDump() { dumper.stop(); }
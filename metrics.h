@@ -0,0 +1,142 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "latency_histogram.h"
+
+// Always-on hot-path metrics: call counts and latency histograms.
+//
+// Each thread writes only to its own block of cache-line-aligned slots,
+// so recording never contends. A block outlives its thread and is handed
+// to the next thread that starts, so totals keep accumulating.
+// collectMetrics() sums every block on demand.
+//
+// A MetricTimer costs two clock reads and a histogram increment. Metrics
+// whose calls are too short to carry that (findItemInStore) count every
+// call but time only one call in 2^sampleShift.
+enum class Metric : unsigned char {
+    BANK_DEPOSIT,
+    BANK_WITHDRAW,
+    BANK_TRANSFER,
+    PAYMENT,            // submit to completion, recorded by the engine
+    FIND_ITEM,
+    REPORT_STORE_ITEMS,
+    REPORT_SPENDING,
+    REPORT_CASH_FLOW,
+    REPORT_TOP_ITEMS,
+    REPORT_LOYAL_CUSTOMERS,
+    REPORT_CUSTOMERS,
+    REPORT_DORMANT,
+    REPORT_TOP_USERS,
+    REPORT_RECENT,
+    REPORT_UNCOMPLETED,
+    REPORT_FREQUENT_ITEMS,
+    REPORT_ACTIVE_BUYERS,
+    REPORT_ACTIVE_SELLERS,
+    COUNT
+};
+
+enum class Counter : unsigned char {
+    WITHDRAW_DECLINED,
+    PAYMENT_DECLINED,
+    ITEM_NOT_FOUND,
+    COUNT
+};
+
+inline constexpr std::size_t kMetricCount = static_cast<std::size_t>(Metric::COUNT);
+inline constexpr std::size_t kCounterCount = static_cast<std::size_t>(Counter::COUNT);
+
+struct alignas(64) MetricSlot {
+    std::atomic<std::uint64_t> calls{0};
+    std::atomic<std::uint64_t> timed{0};
+    std::atomic<std::uint64_t> totalNanos{0};
+    std::atomic<std::uint64_t> maxNanos{0};
+    LatencyHistogram nanos;
+};
+
+struct ThreadMetrics {
+    std::array<MetricSlot, kMetricCount> metrics;
+    alignas(64) std::array<std::atomic<std::uint64_t>, kCounterCount> counters{};
+};
+
+// Only the owning thread writes a block, so a load and a store stand in
+// for an atomic read-modify-write.
+inline void bumpRelaxed(std::atomic<std::uint64_t>& value, std::uint64_t by = 1) {
+    value.store(value.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+inline thread_local ThreadMetrics* currentThreadMetrics = nullptr;
+ThreadMetrics& attachThreadMetrics();
+
+inline ThreadMetrics& threadMetrics() {
+    ThreadMetrics* block = currentThreadMetrics;
+    return block ? *block : attachThreadMetrics();
+}
+
+inline constexpr unsigned sampleShift(Metric metric) { return metric == Metric::FIND_ITEM ? 4 : 0; }
+
+// Records an already measured duration, e.g. one spanning two threads.
+void recordLatency(Metric metric, std::chrono::nanoseconds elapsed);
+
+inline void countEvent(Counter counter) {
+    bumpRelaxed(threadMetrics().counters[static_cast<std::size_t>(counter)]);
+}
+
+// Times its scope into `metric`.
+class MetricTimer {
+private:
+    MetricSlot* slot;   // null when this call is not sampled
+    std::chrono::steady_clock::time_point started;
+
+public:
+    explicit MetricTimer(Metric metric) : slot(&threadMetrics().metrics[static_cast<std::size_t>(metric)]) {
+        std::uint64_t before = slot->calls.load(std::memory_order_relaxed);
+        slot->calls.store(before + 1, std::memory_order_relaxed);
+        if (before & ((std::uint64_t{1} << sampleShift(metric)) - 1)) {
+            slot = nullptr;
+        } else {
+            started = std::chrono::steady_clock::now();
+        }
+    }
+    ~MetricTimer();
+
+    MetricTimer(const MetricTimer&) = delete;
+    MetricTimer& operator=(const MetricTimer&) = delete;
+};
+
+struct MetricSummary {
+    const char* name;
+    std::uint64_t calls;
+    std::uint64_t timed;
+    double meanMicros;
+    double p50Micros;
+    double p99Micros;
+    double p999Micros;
+    double maxMicros;
+};
+
+struct MetricsSnapshot {
+    std::array<MetricSummary, kMetricCount> metrics;
+    std::array<std::uint64_t, kCounterCount> counters;
+    std::size_t threads;   // blocks ever handed out
+};
+
+MetricsSnapshot collectMetrics();
+
+// A table of every metric with calls, then the counters.
+void printMetrics(std::ostream& out);
+
+// Rewrites `path` with printMetrics() output every `interval` until
+// stopMetricsDump() or exit, which write a last one. Returns false if the
+// file cannot be written.
+bool startMetricsDump(const std::string& path, std::chrono::seconds interval);
+void stopMetricsDump();
+
+#endif // METRICS_H
@@ -0,0 +1,109 @@
+#ifndef MPSC_RING_H
+#define MPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <utility>
+
+// Bounded multi-producer single-consumer queue (Vyukov's sequenced ring).
+//
+// Each cell carries a sequence number that says whose turn it is: a
+// producer claims position p with one CAS on `tail` when cell p's sequence
+// equals p, constructs the value and hands the cell to the consumer by
+// storing p + 1. The consumer takes it and stores p + Capacity, which
+// returns the cell to the producer one lap later. Producers never take a
+// lock. When the ring is full they wait for the consumer.
+//
+// push() returns the 1-based position of the value, so the n-th value
+// ever pushed gets ticket n. popped() counts the values the consumer has
+// taken, so a value has left the ring once popped() >= its ticket.
+template <typename T, std::size_t Capacity>
+class MpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+private:
+    struct Cell {
+        std::atomic<std::uint64_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* value() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    alignas(64) std::atomic<std::uint64_t> tail;
+    // Consumer-owned; atomic only so producers and waiters can read it.
+    alignas(64) std::atomic<std::uint64_t> head;
+
+public:
+    MpscRing() : cells(new Cell[Capacity]), tail(0), head(0) {
+        for (std::size_t i = 0; i < Capacity; ++i) cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    ~MpscRing() {
+        popBatch(Capacity, [](T&&) {});
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    static constexpr std::size_t capacity() { return Capacity; }
+
+    // Any thread. Waits while the ring is full.
+    template <typename... Args>
+    std::uint64_t push(Args&&... args) {
+        std::uint64_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & (Capacity - 1)];
+            std::uint64_t seq = cell.sequence.load(std::memory_order_acquire);
+            if (seq == pos) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    new (cell.storage) T(std::forward<Args>(args)...);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    tail.notify_one();
+                    return pos + 1;
+                }
+            } else if (seq < pos) {
+                // Full: the consumer has not yet freed this cell from the last lap.
+                std::this_thread::yield();
+                pos = tail.load(std::memory_order_relaxed);
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer thread only. Hands up to `maxCount` ready values, oldest
+    // first, to sink(T&&) and returns how many it took.
+    template <typename Sink>
+    std::size_t popBatch(std::size_t maxCount, Sink&& sink) {
+        std::uint64_t pos = head.load(std::memory_order_relaxed);
+        std::size_t taken = 0;
+        for (; taken < maxCount; ++taken, ++pos) {
+            Cell& cell = cells[pos & (Capacity - 1)];
+            if (cell.sequence.load(std::memory_order_acquire) != pos + 1) break;
+            T* value = cell.value();
+            sink(std::move(*value));
+            value->~T();
+            cell.sequence.store(pos + Capacity, std::memory_order_release);
+        }
+        if (taken) head.store(pos, std::memory_order_release);
+        return taken;
+    }
+
+    // Consumer thread only, after popBatch() came back empty. Sleeps if no
+    // push has been claimed; yields if one is claimed but not yet written.
+    void waitForPush() const {
+        std::uint64_t claimed = tail.load(std::memory_order_acquire);
+        if (claimed == head.load(std::memory_order_relaxed)) tail.wait(claimed, std::memory_order_acquire);
+        else std::this_thread::yield();
+    }
+
+    std::uint64_t pushed() const { return tail.load(std::memory_order_acquire); }
+    std::uint64_t popped() const { return head.load(std::memory_order_acquire); }
+};
+
+#endif // MPSC_RING_H
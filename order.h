@@ -3,10 +3,13 @@
 
 #include <vector>
 #include <string>
+#include <memory_resource>
 #include <iostream>
 #include <map>
 #include <iomanip>
 
+#include "memory_accounting.h"
+
 using namespace std;
 
 struct OrderItem {
@@ -23,13 +26,23 @@ public:
 private:
     int id;
     int buyerId;
-    vector<OrderItem> items;
+    // Charged to the orders subsystem (memory_accounting.h), copies included.
+    pmr::vector<OrderItem> items{memoryResource(MemoryTag::ORDERS)};
     double totalAmount;
     Status status;
+    // A payment for this invoice has been submitted and not yet settled.
+    bool paying = false;
 
 public:
     Order(int id, int buyerId) : id(id), buyerId(buyerId), totalAmount(0.0), status(PENDING) {}
 
+    Order(const Order& other)
+        : id(other.id), buyerId(other.buyerId), items(other.items, memoryResource(MemoryTag::ORDERS)),
+          totalAmount(other.totalAmount), status(other.status), paying(other.paying) {}
+    Order(Order&&) = default;
+    Order& operator=(const Order&) = default;
+    Order& operator=(Order&&) = default;
+
     void addItem(int itemId, const string& itemName, double price, int quantity, int sellerId) {
         items.push_back({itemId, itemName, price, quantity, sellerId});
         totalAmount += price * quantity;
@@ -39,7 +52,7 @@ public:
     int getBuyerId() const { return buyerId; }
     double getTotalAmount() const { return totalAmount; }
     Status getStatus() const { return status; }
-    const vector<OrderItem>& getItems() const { return items; }
+    const pmr::vector<OrderItem>& getItems() const { return items; }
     string getStatusString() const {
         switch (status) {
             case PENDING: return "PENDING";
@@ -50,18 +63,21 @@ public:
         return "UNKNOWN";
     }
 
+    bool isPaying() const { return paying; }
+    void setPaying(bool inFlight) { paying = inFlight; }
+
     void markAsPaid() { status = PAID; }
     void markAsCanceled() { status = CANCELED; }
     void markAsCompleted() { status = COMPLETED; }
 
-    void printDetails() const {
-        cout << "--- INVOICE ID: " << id << " (Status: " << getStatusString() << ") ---" << endl;
+    void printDetails(ostream& out = cout) const {
+        out << "--- INVOICE ID: " << id << " (Status: " << getStatusString() << ") ---" << endl;
         for (const auto& item : items) {
-            cout << "- " << item.itemName << " x" << item.quantity 
+            out << "- " << item.itemName << " x" << item.quantity 
                  << " @$" << fixed << setprecision(2) << item.price << " (Seller ID: " << item.sellerId << ")" << endl;
         }
-        cout << "TOTAL: $" << fixed << setprecision(2) << totalAmount << endl;
-        cout << "---------------------------------------" << endl;
+        out << "TOTAL: $" << fixed << setprecision(2) << totalAmount << endl;
+        out << "---------------------------------------" << endl;
     }
 };
 
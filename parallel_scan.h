@@ -0,0 +1,103 @@
+#ifndef PARALLEL_SCAN_H
+#define PARALLEL_SCAN_H
+
+#include <algorithm>
+#include <cstddef>
+#include <future>
+#include <vector>
+
+#include "thread_pool.h"
+#include "top_k.h"
+
+// Below this many rows per chunk the hand-off to the pool costs more than
+// the scan itself, so small histories are processed on the calling thread.
+constexpr std::size_t kMinParallelChunk = 16384;
+
+// Splits [0, n) into contiguous chunks, runs `body(begin, end)` for each one
+// on the pool (the caller takes the first chunk) and returns the per-chunk
+// partials in chunk order. Called from one of the pool's own workers, it
+// runs everything inline: waiting there on queued chunks could deadlock.
+// If a chunk throws, the exception is rethrown once every chunk is done.
+template <typename Body>
+auto parallelChunks(std::size_t n, Body body, ThreadPool& pool = analyticsPool(),
+                    std::size_t minChunk = kMinParallelChunk) {
+    using Partial = decltype(body(std::size_t{0}, std::size_t{0}));
+    std::size_t chunks = std::max<std::size_t>(1, std::min(pool.size(), n / std::max<std::size_t>(minChunk, 1)));
+    if (pool.isWorkerThread()) chunks = 1;
+    std::size_t step = (n + chunks - 1) / chunks;
+
+    std::vector<std::future<Partial>> pending;
+    std::vector<Partial> partials;
+    pending.reserve(chunks);
+    partials.reserve(chunks);
+    try {
+        for (std::size_t c = 1; c < chunks; ++c) {
+            std::size_t begin = std::min(n, c * step);
+            std::size_t end = std::min(n, begin + step);
+            pending.push_back(pool.submit([&body, begin, end]() { return body(begin, end); }));
+        }
+        partials.push_back(body(0, std::min(n, step)));
+        for (auto& p : pending) partials.push_back(p.get());
+    } catch (...) {
+        // Queued chunks still refer to `body`; it must outlive them.
+        for (auto& p : pending) {
+            if (p.valid()) p.wait();
+        }
+        throw;
+    }
+    return partials;
+}
+
+// Folds every record into a per-chunk copy of `identity`, then merges the
+// chunk results left to right.
+template <typename Range, typename Partial, typename Fold, typename Merge>
+Partial parallelReduce(const Range& records, const Partial& identity, Fold fold, Merge merge,
+                       ThreadPool& pool = analyticsPool()) {
+    auto partials = parallelChunks(records.size(), [&](std::size_t begin, std::size_t end) {
+        Partial p = identity;
+        for (std::size_t i = begin; i < end; ++i) fold(p, records[i]);
+        return p;
+    }, pool);
+
+    Partial result = std::move(partials.front());
+    for (std::size_t i = 1; i < partials.size(); ++i) merge(result, partials[i]);
+    return result;
+}
+
+// Indices of the records accepted by `keep`, in storage order.
+template <typename Range, typename FilterFn>
+std::vector<std::size_t> parallelFilter(const Range& records, FilterFn keep, ThreadPool& pool = analyticsPool()) {
+    auto partials = parallelChunks(records.size(), [&](std::size_t begin, std::size_t end) {
+        std::vector<std::size_t> hits;
+        for (std::size_t i = begin; i < end; ++i) {
+            if (keep(records[i])) hits.push_back(i);
+        }
+        return hits;
+    }, pool);
+
+    std::vector<std::size_t> result = std::move(partials.front());
+    for (std::size_t i = 1; i < partials.size(); ++i) {
+        result.insert(result.end(), partials[i].begin(), partials[i].end());
+    }
+    return result;
+}
+
+// Builds a TopKAggregator over `records` with one table per chunk.
+template <typename Key, typename Range, typename KeyFn, typename FilterFn = KeepAll, typename WeightFn = UnitWeight>
+auto parallelAggregate(const Range& records, KeyFn key, FilterFn keep = FilterFn(), WeightFn weight = WeightFn(),
+                       ThreadPool& pool = analyticsPool()) {
+    using Weight = decltype(weight(records[0]));
+    using Aggregator = TopKAggregator<Key, Weight>;
+    return parallelReduce(records, Aggregator(),
+        [&](Aggregator& agg, const auto& r) { if (keep(r)) agg.add(key(r), weight(r)); },
+        [](Aggregator& into, const Aggregator& from) { into.merge(from); },
+        pool);
+}
+
+template <typename Key, typename Range, typename KeyFn, typename FilterFn = KeepAll, typename WeightFn = UnitWeight>
+auto parallelTopK(const Range& records, std::size_t k, KeyFn key, FilterFn keep = FilterFn(), WeightFn weight = WeightFn(),
+                  ThreadPool& pool = analyticsPool()) {
+    return parallelAggregate<Key>(records, key, keep, weight, pool).top(k);
+}
+
+#endif // PARALLEL_SCAN_H
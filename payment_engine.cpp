@@ -0,0 +1,208 @@
+#include "payment_engine.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "metrics.h"
+#include "trace.h"
+
+using namespace std;
+
+string invoiceTag(int orderId) {
+    return "Invoice #" + to_string(orderId);
+}
+
+PaymentEngine::PaymentEngine(Bank& bank, atomic<int>& transactionIds, shared_mutex& inventoryMutex,
+                             size_t workers, size_t maxBatch)
+    : bank(bank), transactionIds(transactionIds), inventoryMutex(inventoryMutex), maxBatch(maxBatch ? maxBatch : 1),
+      started(chrono::steady_clock::now()), activeSettlers(workers ? workers : 1), stopping(false) {
+    for (size_t i = 0; i < activeSettlers; ++i) settlers.emplace_back([this] { settleLoop(); });
+    fulfiller = thread([this] { fulfilLoop(); });
+}
+
+PaymentEngine::~PaymentEngine() {
+    {
+        lock_guard<mutex> lock(intakeMutex);
+        stopping = true;
+    }
+    intakeReady.notify_all();
+    for (auto& t : settlers) t.join();
+    fulfiller.join();
+}
+
+future<PaymentResult> PaymentEngine::submit(PaymentRequest request) {
+    auto promised = make_shared<promise<PaymentResult>>();
+    future<PaymentResult> result = promised->get_future();
+    submit(std::move(request), [promised](const PaymentResult& r) { promised->set_value(r); });
+    return result;
+}
+
+void PaymentEngine::submit(PaymentRequest request, Callback done) {
+    TRACE_SPAN("PaymentEngine::submit");
+    {
+        lock_guard<mutex> lock(intakeMutex);
+        intake.push_back(Pending{std::move(request), std::move(done), chrono::steady_clock::now(),
+                                 TransferStatus::OK, {}});
+    }
+    intakeReady.notify_one();
+}
+
+PaymentStats PaymentEngine::stats() const {
+    PaymentStats s;
+    s.completed = completedCount.load(memory_order_relaxed);
+    s.failed = failedCount.load(memory_order_relaxed);
+    s.batches = batchCount.load(memory_order_relaxed);
+    uint64_t batched = batchedCount.load(memory_order_relaxed);
+    s.meanBatchSize = s.batches ? static_cast<double>(batched) / static_cast<double>(s.batches) : 0.0;
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    s.throughputPerSecond = seconds > 0 ? static_cast<double>(s.completed) / seconds : 0.0;
+    s.p50Micros = latencyMicros.percentile(0.50);
+    s.p99Micros = latencyMicros.percentile(0.99);
+    return s;
+}
+
+void PaymentEngine::settleLoop() {
+    vector<Pending> batch;
+    for (;;) {
+        {
+            unique_lock<mutex> lock(intakeMutex);
+            intakeReady.wait(lock, [this] { return stopping || !intake.empty(); });
+            if (intake.empty()) break;
+            while (!intake.empty() && batch.size() < maxBatch) {
+                batch.push_back(std::move(intake.front()));
+                intake.pop_front();
+            }
+        }
+
+        settle(batch);
+        {
+            lock_guard<mutex> lock(settledMutex);
+            settled.push_back(std::move(batch));
+        }
+        settledReady.notify_one();
+        batch.clear();
+    }
+
+    {
+        lock_guard<mutex> lock(settledMutex);
+        --activeSettlers;
+    }
+    settledReady.notify_one();
+}
+
+void PaymentEngine::settle(vector<Pending>& batch) {
+    TRACE_SPAN("PaymentEngine::settle");
+    reserveStock(batch);
+
+    // Debit and credit legs per invoice, under the baseline descriptions.
+    auto invoiceLegs = [&](size_t i, vector<TransferLeg>& legs) {
+        string tag = invoiceTag(batch[i].request.orderId);
+        map<int, double> credits;
+        double debit = 0.0;
+        for (const PaymentLine& line : batch[i].request.lines) {
+            debit += line.amount;
+            credits[line.sellerAccountId] += line.amount;
+            batch[i].sellerCredits[line.sellerId] += line.amount;
+        }
+        legs.push_back({TransferLeg::DEBIT, batch[i].request.buyerAccountId, debit, tag + " Payment"});
+        for (const auto& credit : credits) {
+            legs.push_back({TransferLeg::CREDIT, credit.first, credit.second, tag + " Sale"});
+        }
+    };
+
+    vector<size_t> reserved;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (batch[i].status == TransferStatus::OK) reserved.push_back(i);
+    }
+
+    TransferStatus combined = TransferStatus::EMPTY;
+    if (reserved.size() > 1) {
+        vector<TransferLeg> legs;
+        for (size_t i : reserved) invoiceLegs(i, legs);
+        combined = bank.transfer(legs);
+    }
+
+    bool released = false;
+    for (size_t i : reserved) {
+        if (combined != TransferStatus::OK) {
+            batch[i].sellerCredits.clear();
+            vector<TransferLeg> legs;
+            invoiceLegs(i, legs);
+            batch[i].status = bank.transfer(legs);
+        }
+        if (batch[i].status != TransferStatus::OK) {
+            batch[i].sellerCredits.clear();
+            released = true;
+        }
+    }
+    if (released) releaseStock(batch);
+}
+
+void PaymentEngine::reserveStock(vector<Pending>& batch) {
+    // One stock write per item: walk the invoices in order against a running
+    // count and refuse any invoice that would take an item below zero.
+    unique_lock<shared_mutex> lock(inventoryMutex);
+    map<Item*, int> stock;
+    for (Pending& p : batch) {
+        map<Item*, int> wanted;
+        for (const PaymentLine& line : p.request.lines) {
+            if (line.item) wanted[line.item] += line.quantity;
+        }
+        bool inStock = true;
+        for (const auto& w : wanted) {
+            auto it = stock.try_emplace(w.first, w.first->getQuantity()).first;
+            if (it->second < w.second) inStock = false;
+        }
+        if (!inStock) { p.status = TransferStatus::OUT_OF_STOCK; continue; }
+        for (const auto& w : wanted) stock[w.first] -= w.second;
+    }
+    for (const auto& s : stock) s.first->setQuantity(s.second);
+}
+
+void PaymentEngine::releaseStock(vector<Pending>& batch) {
+    unique_lock<shared_mutex> lock(inventoryMutex);
+    for (const Pending& p : batch) {
+        if (p.status == TransferStatus::OK || p.status == TransferStatus::OUT_OF_STOCK) continue;
+        for (const PaymentLine& line : p.request.lines) {
+            if (line.item) line.item->replenish(line.quantity);
+        }
+    }
+}
+
+void PaymentEngine::fulfilLoop() {
+    for (;;) {
+        vector<Pending> batch;
+        {
+            unique_lock<mutex> lock(settledMutex);
+            settledReady.wait(lock, [this] { return !settled.empty() || activeSettlers == 0; });
+            if (settled.empty()) return;
+            batch = std::move(settled.front());
+            settled.pop_front();
+        }
+        fulfil(batch);
+    }
+}
+
+void PaymentEngine::fulfil(vector<Pending>& batch) {
+    TRACE_SPAN("PaymentEngine::fulfil");
+    batchCount.fetch_add(1, memory_order_relaxed);
+    batchedCount.fetch_add(batch.size(), memory_order_relaxed);
+
+    auto now = chrono::steady_clock::now();
+    for (Pending& p : batch) {
+        PaymentResult result{p.request.orderId, p.status, std::move(p.sellerCredits), LedgerTicket{},
+                             chrono::duration_cast<chrono::microseconds>(now - p.submitted)};
+        string name = invoiceTag(p.request.orderId) + " (" + to_string(p.request.lines.size()) + " items)";
+        for (const auto& credit : result.sellerCredits) {
+            result.ticket = recordTransaction(Transaction(++transactionIds, p.request.buyerId,
+                                                          credit.first, name, credit.second));
+        }
+
+        latencyMicros.record(static_cast<uint64_t>(result.latency.count()));
+        recordLatency(Metric::PAYMENT, now - p.submitted);
+        if (result.status != TransferStatus::OK) countEvent(Counter::PAYMENT_DECLINED);
+        (result.status == TransferStatus::OK ? completedCount : failedCount).fetch_add(1, memory_order_relaxed);
+        if (p.done) p.done(result);
+    }
+}
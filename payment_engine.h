@@ -0,0 +1,138 @@
+#ifndef PAYMENT_ENGINE_H
+#define PAYMENT_ENGINE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bank.h"
+#include "item.h"
+#include "latency_histogram.h"
+#include "ledger.h"
+
+// One invoice line, resolved by the caller so the engine never has to
+// search the store: the seller's bank account and the stocked item.
+struct PaymentLine {
+    int sellerId;
+    int sellerAccountId;
+    Item* item;          // nullptr if the item no longer exists
+    int quantity;
+    double amount;       // price * quantity
+};
+
+struct PaymentRequest {
+    int orderId;
+    int buyerId;
+    int buyerAccountId;
+    std::vector<PaymentLine> lines;
+};
+
+struct PaymentResult {
+    int orderId;
+    TransferStatus status;
+    // Amount credited per seller id; empty unless status is OK.
+    std::map<int, double> sellerCredits;
+    // Ticket of the last transaction record; wait on it to see the sale in reports.
+    LedgerTicket ticket;
+    std::chrono::microseconds latency;
+};
+
+// "Invoice #<id>": prefix of the ledger descriptions for an invoice.
+std::string invoiceTag(int orderId);
+
+struct PaymentStats {
+    std::uint64_t completed;
+    std::uint64_t failed;
+    std::uint64_t batches;
+    double meanBatchSize;
+    double throughputPerSecond;   // completed payments since the engine started
+    std::uint64_t p50Micros;
+    std::uint64_t p99Micros;
+};
+
+// Settles invoices in two pipelined stages:
+//
+//  1. Settlement (worker pool): each worker takes up to `maxBatch` queued
+//     invoices and reserves their stock, failing any invoice the shelves
+//     cannot cover with OUT_OF_STOCK. It then settles the rest with one
+//     Bank::transfer carrying every invoice's own debit and credit legs.
+//     If that combined transfer is refused, each invoice is retried on its
+//     own so one underfunded buyer cannot fail the others, and the stock of
+//     every invoice that still fails is put back.
+//  2. Fulfilment (single thread): takes settled batches in order, records
+//     a Transaction per (invoice, seller) and completes the callers.
+//
+// Stock is read and written under the store's inventory lock, taken once
+// per batch to reserve and once more only if some reservation is released.
+class PaymentEngine {
+public:
+    using Callback = std::function<void(const PaymentResult&)>;
+
+    PaymentEngine(Bank& bank, std::atomic<int>& transactionIds, std::shared_mutex& inventoryMutex,
+                  std::size_t workers = 2, std::size_t maxBatch = 32);
+    ~PaymentEngine();
+
+    PaymentEngine(const PaymentEngine&) = delete;
+    PaymentEngine& operator=(const PaymentEngine&) = delete;
+
+    std::future<PaymentResult> submit(PaymentRequest request);
+    // `done` runs on the fulfilment thread and must not block on the engine.
+    void submit(PaymentRequest request, Callback done);
+
+    PaymentStats stats() const;
+
+private:
+    struct Pending {
+        PaymentRequest request;
+        Callback done;
+        std::chrono::steady_clock::time_point submitted;
+        TransferStatus status;
+        std::map<int, double> sellerCredits;
+    };
+
+    Bank& bank;
+    std::atomic<int>& transactionIds;
+    std::shared_mutex& inventoryMutex;
+    std::size_t maxBatch;
+    std::chrono::steady_clock::time_point started;
+
+    std::mutex intakeMutex;
+    std::condition_variable intakeReady;
+    std::deque<Pending> intake;
+
+    std::mutex settledMutex;
+    std::condition_variable settledReady;
+    std::deque<std::vector<Pending>> settled;
+    std::size_t activeSettlers;
+
+    bool stopping;
+
+    std::atomic<std::uint64_t> completedCount{0};
+    std::atomic<std::uint64_t> failedCount{0};
+    std::atomic<std::uint64_t> batchCount{0};
+    std::atomic<std::uint64_t> batchedCount{0};
+    LatencyHistogram latencyMicros;
+
+    std::vector<std::thread> settlers;
+    std::thread fulfiller;
+
+    void settleLoop();
+    void fulfilLoop();
+    void settle(std::vector<Pending>& batch);
+    void reserveStock(std::vector<Pending>& batch);
+    void releaseStock(std::vector<Pending>& batch);
+    void fulfil(std::vector<Pending>& batch);
+};
+
+#endif // PAYMENT_ENGINE_H
@@ -0,0 +1,791 @@
+#include "protocol.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "approx_analytics.h"
+#include "clock.h"
+#include "export.h"
+#include "inventory_import.h"
+#include "ledger.h"
+#include "memory_accounting.h"
+#include "metrics.h"
+#include "reports.h"
+#include "store.h"
+#include "trace.h"
+
+using namespace std;
+
+namespace {
+
+// Whitespace-separated arguments of one request line.
+class CommandArgs {
+private:
+    string_view rest;
+
+    void skipSpace() {
+        while (!rest.empty() && isspace(static_cast<unsigned char>(rest.front()))) rest.remove_prefix(1);
+    }
+
+public:
+    explicit CommandArgs(string_view line) : rest(line) {}
+
+    string_view word() {
+        skipSpace();
+        size_t end = 0;
+        while (end < rest.size() && !isspace(static_cast<unsigned char>(rest[end]))) ++end;
+        string_view w = rest.substr(0, end);
+        rest.remove_prefix(end);
+        return w;
+    }
+
+    template <typename T>
+    bool next(T& value) {
+        string_view w = word();
+        auto [ptr, ec] = from_chars(w.data(), w.data() + w.size(), value);
+        return !w.empty() && ec == errc() && ptr == w.data() + w.size();
+    }
+
+    // Takes the next word if it is `key`=value, storing the value.
+    bool option(string_view key, string_view& value) {
+        skipSpace();
+        if (rest.size() <= key.size() || rest.substr(0, key.size()) != key || rest[key.size()] != '=') return false;
+        value = word().substr(key.size() + 1);
+        return true;
+    }
+
+    // Everything left on the line, trimmed; for names with spaces.
+    string_view remainder() {
+        skipSpace();
+        string_view r = rest;
+        while (!r.empty() && isspace(static_cast<unsigned char>(r.back()))) r.remove_suffix(1);
+        rest = {};
+        return r;
+    }
+};
+
+using Handler = bool (*)(ClientState&, CommandArgs&, ostream&);
+
+// OPERATOR commands change process-wide settings, so only drivers that run
+// on the operator's behalf (executeCommand, i.e. replay) may use them;
+// network sessions are refused.
+enum Needs { ANYONE, BUYER, SELLER, OPERATOR };
+
+struct Command {
+    const char* name;
+    Needs needs;
+    // Reports read the ledger, whose writes are applied asynchronously.
+    bool readsLedger;
+    Handler run;
+    const char* usage;
+};
+
+bool fail(ostream& out, const char* message) {
+    out << message << "\n";
+    return false;
+}
+
+// Whether `word` spells `name` (upper case) in any case.
+bool sameCommand(string_view word, const char* name) {
+    string_view n(name);
+    return word.size() == n.size() && equal(word.begin(), word.end(), n.begin(), [](char a, char b) {
+        return toupper(static_cast<unsigned char>(a)) == b;
+    });
+}
+
+string dataDir;
+
+// `name` as a path inside dataDir; false, with the reason in `out`, if
+// file access is off or the name is absolute or climbs out with "..".
+bool dataPath(string_view name, string& path, ostream& out) {
+    if (dataDir.empty()) return fail(out, "file access is disabled (start with --data-dir)");
+    filesystem::path relative(name);
+    if (name.empty() || relative.has_root_path()) return fail(out, "file name must be relative to the data directory");
+    for (const auto& part : relative) {
+        if (part == "..") return fail(out, "file name must not contain ..");
+    }
+    path = (filesystem::path(dataDir) / relative).string();
+    return true;
+}
+
+bool login(ClientState& s, CommandArgs& args, ostream& out) {
+    string_view who = args.word();
+    int id = 0;
+    auto [end, ec] = from_chars(who.data(), who.data() + who.size(), id);
+    Buyer* buyer = nullptr;
+    if (!who.empty() && ec == errc() && end == who.data() + who.size()) {
+        buyer = findBuyer(id);
+    } else if (who.find('@') != string_view::npos) {
+        buyer = findBuyerByEmail(who);
+    } else {
+        return fail(out, "usage: LOGIN <buyerId|email>");
+    }
+    if (!buyer) return fail(out, "buyer not found");
+    s.currentBuyer = buyer;
+    s.currentSeller = findSeller(buyer->getId());
+    s.isLoggedIn = true;
+    s.cart.clear();
+    out << "buyer " << buyer->getId() << " " << buyer->getName() << "\n";
+    return true;
+}
+
+bool logout(ClientState& s, CommandArgs&, ostream& out) {
+    s.logout();
+    out << "logged out\n";
+    return true;
+}
+
+constexpr const char* kRegisterSyntax = "REGISTER <deposit> [email=ADDRESS] [phone=NUMBER] <name>";
+
+bool registerUsage(ostream& out) {
+    out << "usage: " << kRegisterSyntax << "\n";
+    return false;
+}
+
+// Contact details, if given, make the buyer reachable by LOGIN <email>;
+// createAccount rejects malformed or already registered ones.
+bool registerBuyer(ClientState& s, CommandArgs& args, ostream& out) {
+    double deposit;
+    if (!args.next(deposit) || deposit < 0) return registerUsage(out);
+    string_view email, phone;
+    while (args.option("email", email) || args.option("phone", phone)) {}
+    string name(args.remainder());
+    if (name.empty()) return registerUsage(out);
+
+    BankCustomer& account = myBank.createAccount(name, deposit, "", string(phone), string(email));
+    printAccountCreated(account, out);
+    Buyer& buyer = addBuyer(name, account);
+    s.currentBuyer = &buyer;
+    s.currentSeller = nullptr;
+    s.isLoggedIn = true;
+    s.cart.clear();
+    out << "buyer " << buyer.getId() << " account " << account.getId() << "\n";
+    return true;
+}
+
+bool upgrade(ClientState& s, CommandArgs& args, ostream& out) {
+    if (s.currentSeller) return fail(out, "already a seller");
+    string storeName(args.remainder());
+    if (storeName.empty()) return fail(out, "usage: UPGRADE <store name>");
+    s.currentSeller = addSeller(*s.currentBuyer, storeName);
+    if (!s.currentSeller) {
+        s.currentSeller = findSeller(s.currentBuyer->getId());
+        return fail(out, "already a seller");
+    }
+    out << "seller " << s.currentSeller->getId() << " " << storeName << "\n";
+    return true;
+}
+
+bool balance(ClientState& s, CommandArgs&, ostream& out) {
+    out << s.currentBuyer->getAccount().getBalance() << "\n";
+    return true;
+}
+
+bool deposit(ClientState& s, CommandArgs& args, ostream& out) {
+    double amount;
+    if (!args.next(amount)) return fail(out, "usage: DEPOSIT <amount>");
+    BankCustomer& account = s.currentBuyer->getAccount();
+    TransferStatus status = myBank.deposit(account.getId(), amount);
+    printBalanceChange("Deposit", status, &account, out);
+    return status == TransferStatus::OK;
+}
+
+bool withdraw(ClientState& s, CommandArgs& args, ostream& out) {
+    double amount;
+    if (!args.next(amount)) return fail(out, "usage: WITHDRAW <amount>");
+    BankCustomer& account = s.currentBuyer->getAccount();
+    TransferStatus status = myBank.withdraw(account.getId(), amount);
+    printBalanceChange("Withdraw", status, &account, out);
+    return status == TransferStatus::OK;
+}
+
+bool cashFlow(ClientState& s, CommandArgs& args, ostream& out) {
+    string_view period = args.word();
+    if (period == "TODAY" || period == "today") listCashFlowToday(s.currentBuyer->getAccount(), out);
+    else if (period == "MONTH" || period == "month") listCashFlowLastMonth(s.currentBuyer->getAccount(), out);
+    else return fail(out, "usage: CASHFLOW TODAY|MONTH");
+    return true;
+}
+
+bool spending(ClientState& s, CommandArgs& args, ostream& out) {
+    int k;
+    if (!args.next(k) || k <= 0) return fail(out, "usage: SPENDING <days>");
+    checkSpendingLastKDays(*s.currentBuyer, k, out);
+    return true;
+}
+
+bool browse(ClientState&, CommandArgs&, ostream& out) {
+    listStoreItems(out);
+    return true;
+}
+
+bool addToCart(ClientState& s, CommandArgs& args, ostream& out) {
+    int itemId, qty;
+    if (!args.next(itemId) || !args.next(qty)) return fail(out, "usage: ADD <itemId> <quantity>");
+    if (qty <= 0) return fail(out, "quantity must be positive");
+
+    shared_lock<shared_mutex> lock(inventoryMutex);
+    seller* itemSeller = nullptr;
+    Item* item = findItemInStore(itemId, itemSeller);
+    if (!item || !item->isDisplayed()) return fail(out, "item not found");
+    if (!item->checkAvailability(qty)) {
+        out << "insufficient stock, available " << item->getQuantity() << "\n";
+        return false;
+    }
+    s.cart.push_back({item->getId(), item->getName(), item->getPrice(), qty, itemSeller->getId()});
+    out << "cart " << s.cart.size() << "\n";
+    return true;
+}
+
+bool showCart(ClientState& s, CommandArgs&, ostream& out) {
+    double total = 0.0;
+    for (const OrderItem& line : s.cart) {
+        out << line.itemId << " " << line.itemName << " x" << line.quantity << " @ " << line.price << "\n";
+        total += line.price * line.quantity;
+    }
+    out << "total " << total << "\n";
+    return true;
+}
+
+bool checkout(ClientState& s, CommandArgs&, ostream& out) {
+    if (s.cart.empty()) return fail(out, "cart is empty");
+    Order invoice(++orderIdCounter, s.currentBuyer->getId());
+    for (const OrderItem& line : s.cart) {
+        invoice.addItem(line.itemId, line.itemName, line.price, line.quantity, line.sellerId);
+    }
+    s.cart.clear();
+    s.currentBuyer->addOrder(invoice);
+    out << "invoice " << invoice.getId() << " total " << invoice.getTotalAmount() << "\n";
+    return true;
+}
+
+bool orders(ClientState& s, CommandArgs&, ostream& out) {
+    lock_guard<mutex> lock(s.currentBuyer->getOrdersMutex());
+    for (const Order& order : s.currentBuyer->getOrders()) order.printDetails(out);
+    return true;
+}
+
+bool addItem(ClientState& s, CommandArgs& args, ostream& out) {
+    int qty;
+    double price;
+    if (!args.next(qty) || !args.next(price)) return fail(out, "usage: ITEM <quantity> <price> <name>");
+    string name(args.remainder());
+    if (qty <= 0 || price <= 0 || name.empty()) return fail(out, "usage: ITEM <quantity> <price> <name>");
+
+    unique_lock<shared_mutex> lock(inventoryMutex);
+    int newId = addStoreItem(*s.currentSeller, name, qty, price);
+    out << "item " << newId << "\n";
+    return true;
+}
+
+// Reads a catalog file from the server's data directory; see
+// inventory_import.h for formats.
+bool importItems(ClientState& s, CommandArgs& args, ostream& out) {
+    string_view name = args.remainder();
+    if (name.empty()) return fail(out, "usage: IMPORT <path>");
+    string path;
+    if (!dataPath(name, path, out)) return false;
+    ifstream file(path, ios::binary);
+    if (!file) return fail(out, "cannot open import file");
+
+    ImportResult result = importInventory(*s.currentSeller, file);
+    out << "imported " << result.imported << " items";
+    if (result.imported > 0) out << " (ids " << result.firstId << "-" << result.lastId << ")";
+    out << ", rejected " << result.rejected;
+    if (result.rejected > 0) out << " (first at row " << result.firstRejectedRow << ")";
+    out << "\n";
+    if (!result.error.empty()) out << result.error << "\n";
+    return result.error.empty();
+}
+
+bool restock(ClientState& s, CommandArgs& args, ostream& out) {
+    int itemId, amount;
+    if (!args.next(itemId) || !args.next(amount) || amount <= 0) return fail(out, "usage: RESTOCK <itemId> <amount>");
+    unique_lock<shared_mutex> lock(inventoryMutex);
+    if (!s.currentSeller->replenishItem(itemId, amount)) return fail(out, "item not found");
+    out << "stock " << s.currentSeller->findItemById(itemId)->getQuantity() << "\n";
+    return true;
+}
+
+bool discard(ClientState& s, CommandArgs& args, ostream& out) {
+    int itemId, amount;
+    if (!args.next(itemId) || !args.next(amount) || amount <= 0) return fail(out, "usage: DISCARD <itemId> <amount>");
+    unique_lock<shared_mutex> lock(inventoryMutex);
+    if (!s.currentSeller->discardItem(itemId, amount)) return fail(out, "insufficient stock or item not found");
+    out << "stock " << s.currentSeller->findItemById(itemId)->getQuantity() << "\n";
+    return true;
+}
+
+bool setPrice(ClientState& s, CommandArgs& args, ostream& out) {
+    int itemId;
+    double price;
+    if (!args.next(itemId) || !args.next(price) || price <= 0) return fail(out, "usage: PRICE <itemId> <price>");
+    unique_lock<shared_mutex> lock(inventoryMutex);
+    if (!s.currentSeller->findItemById(itemId)) return fail(out, "item not found");
+    s.currentSeller->setItemPrice(itemId, price);
+    out << "price " << price << "\n";
+    return true;
+}
+
+bool topItems(ClientState& s, CommandArgs& args, ostream& out) {
+    int k;
+    if (!args.next(k) || k <= 0) return fail(out, "usage: TOPITEMS <k>");
+    discoverTopItemsPerMonth(*s.currentSeller, k, out);
+    return true;
+}
+
+bool loyal(ClientState& s, CommandArgs&, ostream& out) {
+    discoverLoyalCustomerPerMonth(*s.currentSeller, out);
+    return true;
+}
+
+bool recent(ClientState&, CommandArgs& args, ostream& out) {
+    int k;
+    if (!args.next(k) || k <= 0) return fail(out, "usage: RECENT <days>");
+    listRecentTransactions(k, out);
+    return true;
+}
+
+bool uncompleted(ClientState&, CommandArgs&, ostream& out) {
+    listUncompletedTransactions(out);
+    return true;
+}
+
+bool frequent(ClientState&, CommandArgs& args, ostream& out) {
+    int m;
+    if (!args.next(m) || m <= 0) return fail(out, "usage: FREQUENT <m>");
+    listMostFrequentItems(m, out);
+    return true;
+}
+
+bool activeBuyers(ClientState&, CommandArgs&, ostream& out) {
+    listMostActiveBuyers(out);
+    return true;
+}
+
+bool activeSellers(ClientState&, CommandArgs&, ostream& out) {
+    listMostActiveSellers(out);
+    return true;
+}
+
+bool paymentStats(ClientState&, CommandArgs&, ostream& out) {
+    showPaymentStats(out);
+    return true;
+}
+
+bool reportStatsCommand(ClientState&, CommandArgs&, ostream& out) {
+    showReportStats(out);
+    return true;
+}
+
+bool metrics(ClientState&, CommandArgs&, ostream& out) {
+    printMetrics(out);
+    return true;
+}
+
+bool memory(ClientState&, CommandArgs& args, ostream& out) {
+    string_view format = args.word();
+    if (format.empty()) {
+        printMemoryReport(out);
+    } else if (format == "JSON") {
+        dumpMemoryUsage(out);
+    } else {
+        return fail(out, "usage: MEMORY [JSON]");
+    }
+    return true;
+}
+
+constexpr const char* kClockSyntax = "CLOCK [SYSTEM|COARSE [ms]|SIMULATED|ADVANCE <days>]";
+
+bool clockUsage(ostream& out) {
+    out << "usage: " << kClockSyntax << "\n";
+    return false;
+}
+
+// Reads or switches the clock records and report windows use (clock.h).
+// SIMULATED freezes time at the current moment; ADVANCE then moves it on.
+bool clockCommand(ClientState&, CommandArgs& args, ostream& out) {
+    string_view mode = args.word();
+    int count = 0;
+    string_view number = args.word();
+    if (!number.empty()) {
+        auto [ptr, ec] = from_chars(number.data(), number.data() + number.size(), count);
+        if (ec != errc() || ptr != number.data() + number.size() || count <= 0) return clockUsage(out);
+    }
+    if (sameCommand(mode, "SYSTEM") && number.empty()) {
+        useSystemClock();
+    } else if (sameCommand(mode, "COARSE")) {
+        useCoarseClock(chrono::milliseconds(number.empty() ? 1 : count));
+    } else if (sameCommand(mode, "SIMULATED") && number.empty()) {
+        useSimulatedClock(clockNow());
+    } else if (sameCommand(mode, "ADVANCE") && !number.empty()) {
+        if (!advanceClock(chrono::hours(24) * count)) return fail(out, "clock is not simulated");
+    } else if (!mode.empty()) {
+        return clockUsage(out);
+    }
+    time_t now = chrono::system_clock::to_time_t(clockNow());
+    struct tm local;
+    localtime_r(&now, &local);
+    out << "clock " << clockModeName(clockMode()) << " " << put_time(&local, "%Y-%m-%d %H:%M:%S") << "\n";
+    return true;
+}
+
+constexpr const char* kTraceSyntax = "TRACE ON [every]|OFF|DUMP <path>";
+
+bool traceUsage(ostream& out) {
+    out << "usage: " << kTraceSyntax << "\n";
+    return false;
+}
+
+// Samples one command in `every` (with the spans nested in it) until OFF;
+// DUMP writes what has been captured as Chrome trace JSON into the server's
+// data directory.
+bool trace(ClientState&, CommandArgs& args, ostream& out) {
+    string_view mode = args.word();
+    if (mode == "ON" || mode == "on") {
+        int every = 1;
+        string_view count = args.word();
+        if (!count.empty()) {
+            auto [ptr, ec] = from_chars(count.data(), count.data() + count.size(), every);
+            if (ec != errc() || ptr != count.data() + count.size() || every <= 0) return traceUsage(out);
+        }
+        setTraceSampling(static_cast<unsigned>(every));
+        out << "tracing 1 in " << every << "\n";
+    } else if (mode == "OFF" || mode == "off") {
+        setTraceSampling(0);
+        out << "tracing off\n";
+    } else if (mode == "DUMP" || mode == "dump") {
+        string_view name = args.remainder();
+        if (name.empty()) return traceUsage(out);
+        string path;
+        if (!dataPath(name, path, out)) return false;
+        ofstream file(path, ios::trunc);
+        if (!file) return fail(out, "cannot open trace file");
+        size_t spans = writeChromeTrace(file);
+        out << "wrote " << spans << " spans\n";
+    } else {
+        return traceUsage(out);
+    }
+    return true;
+}
+
+bool customers(ClientState&, CommandArgs&, ostream& out) {
+    listAllCustomers(out);
+    return true;
+}
+
+bool dormant(ClientState&, CommandArgs&, ostream& out) {
+    listDormantAccounts(out);
+    return true;
+}
+
+bool topUsers(ClientState&, CommandArgs& args, ostream& out) {
+    int n;
+    if (!args.next(n) || n <= 0) return fail(out, "usage: TOPUSERS <n>");
+    listTopUsersToday(n, out);
+    return true;
+}
+
+bool approximate(ClientState&, CommandArgs& args, ostream& out) {
+    string_view mode = args.word();
+    if (mode == "ON" || mode == "on") approximateAnalytics = true;
+    else if (mode == "OFF" || mode == "off") approximateAnalytics = false;
+    else return fail(out, "usage: APPROX ON|OFF");
+    out << "approximate " << (approximateAnalytics ? "on" : "off") << "\n";
+    return true;
+}
+
+bool ping(ClientState&, CommandArgs&, ostream& out) {
+    out << "pong\n";
+    return true;
+}
+
+constexpr const char* kExportSyntax =
+    "EXPORT TRANSACTIONS|CASHFLOWS CSV|NDJSON [since=T] [until=T] [account=N] [seller=N] [file=PATH]";
+
+bool exportUsage(ostream& out) {
+    out << "usage: " << kExportSyntax << "\n";
+    return false;
+}
+
+// Rows go into the reply body, or with file= straight to a file in the
+// server's data directory so that large extracts are never buffered.
+bool exportHistory(ClientState&, CommandArgs& args, ostream& out) {
+    ExportOptions options;
+    string_view table = args.word(), format = args.word();
+    if (table == "TRANSACTIONS" || table == "transactions") options.table = ExportOptions::Table::TRANSACTIONS;
+    else if (table == "CASHFLOWS" || table == "cashflows") options.table = ExportOptions::Table::CASH_FLOWS;
+    else return exportUsage(out);
+    if (format == "CSV" || format == "csv") options.format = ExportOptions::Format::CSV;
+    else if (format == "NDJSON" || format == "ndjson") options.format = ExportOptions::Format::NDJSON;
+    else return exportUsage(out);
+
+    string_view path;
+    for (string_view option = args.word(); !option.empty(); option = args.word()) {
+        size_t eq = option.find('=');
+        if (eq == string_view::npos) return exportUsage(out);
+        string_view key = option.substr(0, eq), value = option.substr(eq + 1);
+        bool ok;
+        if (key == "since") ok = parseExportTime(value, options.since);
+        else if (key == "until") ok = parseExportTime(value, options.until);
+        else if (key == "account") ok = CommandArgs(value).next(options.account);
+        else if (key == "seller") ok = CommandArgs(value).next(options.seller);
+        else if (key == "file") ok = !(path = value).empty();
+        else ok = false;
+        if (!ok) return exportUsage(out);
+    }
+    if (options.table == ExportOptions::Table::CASH_FLOWS && options.seller != ExportOptions::kAny) {
+        return fail(out, "cash flows have no seller; filter by account=");
+    }
+
+    if (path.empty()) {
+        exportLedger(options, out);
+        return true;
+    }
+    string target;
+    if (!dataPath(path, target, out)) return false;
+    ofstream file{target, ios::binary | ios::trunc};
+    if (!file) return fail(out, "cannot open export file");
+    size_t rows = exportLedger(options, file);
+    file.close();
+    if (!file) return fail(out, "export file write failed");
+    out << "exported " << rows << " rows to " << path << "\n";
+    return true;
+}
+
+bool help(ClientState&, CommandArgs&, ostream& out);
+
+// PAY is dispatched separately: it is the one command that waits.
+const Command commands[] = {
+    {"LOGIN", ANYONE, false, login, "LOGIN <buyerId|email>"},
+    {"REGISTER", ANYONE, false, registerBuyer, kRegisterSyntax},
+    {"LOGOUT", ANYONE, false, logout, "LOGOUT"},
+    {"UPGRADE", BUYER, false, upgrade, "UPGRADE <store name>"},
+    {"BALANCE", BUYER, false, balance, "BALANCE"},
+    {"DEPOSIT", BUYER, false, deposit, "DEPOSIT <amount>"},
+    {"WITHDRAW", BUYER, false, withdraw, "WITHDRAW <amount>"},
+    {"CASHFLOW", BUYER, false, cashFlow, "CASHFLOW TODAY|MONTH"},
+    {"SPENDING", BUYER, true, spending, "SPENDING <days>"},
+    {"BROWSE", ANYONE, false, browse, "BROWSE"},
+    {"ADD", BUYER, false, addToCart, "ADD <itemId> <quantity>"},
+    {"CART", BUYER, false, showCart, "CART"},
+    {"CHECKOUT", BUYER, false, checkout, "CHECKOUT"},
+    {"ORDERS", BUYER, false, orders, "ORDERS"},
+    {"ITEM", SELLER, false, addItem, "ITEM <quantity> <price> <name>"},
+    {"IMPORT", SELLER, false, importItems, "IMPORT <path>"},
+    {"RESTOCK", SELLER, false, restock, "RESTOCK <itemId> <amount>"},
+    {"DISCARD", SELLER, false, discard, "DISCARD <itemId> <amount>"},
+    {"PRICE", SELLER, false, setPrice, "PRICE <itemId> <price>"},
+    {"TOPITEMS", SELLER, true, topItems, "TOPITEMS <k>"},
+    {"LOYAL", SELLER, true, loyal, "LOYAL"},
+    {"RECENT", ANYONE, true, recent, "RECENT <days>"},
+    {"UNCOMPLETED", ANYONE, true, uncompleted, "UNCOMPLETED"},
+    {"FREQUENT", ANYONE, true, frequent, "FREQUENT <m>"},
+    {"ACTIVEBUYERS", ANYONE, true, activeBuyers, "ACTIVEBUYERS"},
+    {"ACTIVESELLERS", ANYONE, true, activeSellers, "ACTIVESELLERS"},
+    {"EXPORT", ANYONE, true, exportHistory, kExportSyntax},
+    {"PAYSTATS", ANYONE, false, paymentStats, "PAYSTATS"},
+    {"REPORTSTATS", ANYONE, false, reportStatsCommand, "REPORTSTATS"},
+    {"METRICS", ANYONE, false, metrics, "METRICS"},
+    {"MEMORY", ANYONE, false, memory, "MEMORY [JSON]"},
+    {"TRACE", ANYONE, false, trace, kTraceSyntax},
+    {"CLOCK", OPERATOR, false, clockCommand, kClockSyntax},
+    {"CUSTOMERS", ANYONE, false, customers, "CUSTOMERS"},
+    {"DORMANT", ANYONE, true, dormant, "DORMANT"},
+    {"TOPUSERS", ANYONE, true, topUsers, "TOPUSERS <n>"},
+    {"APPROX", ANYONE, false, approximate, "APPROX ON|OFF"},
+    {"PING", ANYONE, false, ping, "PING"},
+    {"HELP", ANYONE, false, help, "HELP"},
+};
+
+bool help(ClientState&, CommandArgs&, ostream& out) {
+    for (const Command& c : commands) out << c.usage << "\n";
+    out << "PAY [invoiceId]\nQUIT\n";
+    return true;
+}
+
+const Command* findCommand(string_view word) {
+    for (const Command& c : commands) {
+        if (sameCommand(word, c.name)) return &c;
+    }
+    return nullptr;
+}
+
+// The invoice a PAY request names, or the buyer's latest pending one;
+// nullptr (with the reason in `out`) if it cannot be paid. The invoice is
+// claimed for this payment until settle(), so another session logged in
+// as the same buyer cannot pay it twice.
+Order* invoiceToPay(ClientState& s, CommandArgs& args, ostream& out) {
+    if (!s.currentBuyer) {
+        fail(out, "login required");
+        return nullptr;
+    }
+
+    int invoiceId = 0;
+    string_view given = args.remainder();
+    if (!given.empty()) {
+        CommandArgs id(given);
+        if (!id.next(invoiceId) || invoiceId <= 0) {
+            fail(out, "usage: PAY [invoiceId]");
+            return nullptr;
+        }
+    }
+    Order* order = nullptr;
+    lock_guard<mutex> lock(s.currentBuyer->getOrdersMutex());
+    auto& history = s.currentBuyer->getOrders();
+    if (invoiceId == 0) {
+        auto it = find_if(history.rbegin(), history.rend(),
+                          [](const Order& o) { return o.getStatus() == Order::PENDING && !o.isPaying(); });
+        if (it != history.rend()) order = &*it;
+    } else {
+        auto it = find_if(history.begin(), history.end(),
+                          [&](const Order& o) { return o.getId() == invoiceId; });
+        if (it != history.end()) order = &*it;
+    }
+    if (!order) {
+        fail(out, invoiceId ? "invoice not found" : "no pending invoice");
+        return nullptr;
+    }
+    if (order->getStatus() != Order::PENDING) {
+        out << "invoice is already " << order->getStatusString() << "\n";
+        return nullptr;
+    }
+    if (order->isPaying()) {
+        fail(out, "invoice is already being paid");
+        return nullptr;
+    }
+    order->setPaying(true);
+    return order;
+}
+
+// Releases the claim invoiceToPay() took, marking the invoice paid if the
+// payment went through.
+bool settle(Buyer& buyer, Order& order, const PaymentResult& result, ostream& out) {
+    {
+        lock_guard<mutex> lock(buyer.getOrdersMutex());
+        order.setPaying(false);
+        if (result.status == TransferStatus::OK) order.markAsPaid();
+    }
+    if (result.status != TransferStatus::OK) {
+        out << transferStatusString(result.status) << "\n";
+        return false;
+    }
+    out << "paid " << order.getId() << "\n";
+    for (const auto& credit : result.sellerCredits) {
+        out << "credit " << credit.first << " " << credit.second << "\n";
+    }
+    return true;
+}
+
+// Runs any command but PAY and QUIT; `local` for drivers the operator runs.
+bool dispatch(ClientState& s, string_view name, CommandArgs& args, ostream& out, bool local) {
+    const Command* command = findCommand(name);
+    if (!command) {
+        out << "unknown command " << name << "\n";
+        return false;
+    }
+    TRACE_SPAN(command->name);
+    if (command->needs == OPERATOR && !local) return fail(out, "not available over the network");
+    if (command->needs != ANYONE && command->needs != OPERATOR && !s.currentBuyer) return fail(out, "login required");
+    if (command->needs == SELLER && !s.currentSeller) return fail(out, "seller account required");
+    if (command->readsLedger) syncLedger();
+    try {
+        return command->run(s, args, out);
+    } catch (const exception& e) {
+        out << e.what() << "\n";
+        return false;
+    }
+}
+
+mutex recorderMutex;
+ostream* recorder = nullptr;
+
+void record(int client, string_view line) {
+    lock_guard<mutex> lock(recorderMutex);
+    if (recorder) *recorder << '@' << client << ' ' << line << '\n';
+}
+
+void reply(ostream& out, bool ok, string_view body) {
+    out << (ok ? "OK " : "ERR ") << body.size() << "\n";
+    out.write(body.data(), static_cast<streamsize>(body.size()));
+}
+
+} // namespace
+
+void setProtocolDataDir(const string& dir) { dataDir = dir; }
+
+void recordCommands(ostream* log) {
+    lock_guard<mutex> lock(recorderMutex);
+    if (recorder) recorder->flush();
+    recorder = log;
+}
+
+Task<> commandSession(Session& s) {
+    ostringstream body;
+    body << fixed << setprecision(2);
+    string line;
+    for (;;) {
+        co_await s.readLine(line);
+        CommandArgs args(line);
+        string_view name = args.word();
+        if (name.empty()) continue;
+        record(s.getId(), line);
+
+        body.str("");
+        bool ok;
+        if (sameCommand(name, "QUIT")) {
+            reply(s.out, true, "bye\n");
+            co_return;
+        } else if (sameCommand(name, "PAY")) {
+            // Spans must not stay open across the co_await, so the two
+            // halves of a payment are traced separately.
+            ok = false;
+            Order* order = nullptr;
+            PaymentRequest request{};
+            {
+                TRACE_SPAN("PAY");
+                order = invoiceToPay(s, args, body);
+                if (order) request = paymentRequestFor(*order, *s.currentBuyer);
+            }
+            if (order) {
+                Buyer& buyer = *s.currentBuyer;
+                PaymentResult result = co_await s.pay(paymentEngine(), std::move(request));
+                TRACE_SPAN("PAY.settle");
+                ok = settle(buyer, *order, result, body);
+            }
+        } else {
+            ok = dispatch(s, name, args, body, false);
+        }
+        reply(s.out, ok, body.view());
+    }
+}
+
+bool executeCommand(ClientState& client, string_view line, ostream& body) {
+    CommandArgs args(line);
+    string_view name = args.word();
+    if (name.empty()) return true;
+    if (sameCommand(name, "QUIT")) {
+        client.logout();
+        body << "bye\n";
+        return true;
+    }
+    if (sameCommand(name, "PAY")) {
+        TRACE_SPAN("PAY");
+        Order* order = invoiceToPay(client, args, body);
+        if (!order) return false;
+        Buyer& buyer = *client.currentBuyer;
+        return settle(buyer, *order, paymentEngine().submit(paymentRequestFor(*order, buyer)).get(), body);
+    }
+    return dispatch(client, name, args, body, true);
+}
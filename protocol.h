@@ -0,0 +1,42 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "client_state.h"
+#include "session.h"
+#include "task.h"
+
+// Line protocol for programmatic clients. Each request is one line:
+//
+//     COMMAND arg...\n
+//
+// and each reply is a header line followed by exactly <length> bytes:
+//
+//     OK <length>\n<body>      or      ERR <length>\n<body>
+//
+// Requests may be pipelined: a client can send any number of lines without
+// waiting, and replies come back in request order. Commands are matched
+// case-insensitively; HELP lists them. QUIT replies and ends the session.
+Task<> commandSession(Session& s);
+
+// Runs one request line for `client` on the calling thread and writes the
+// reply body (without the OK/ERR header) to `body`; returns whether it
+// succeeded. PAY blocks until the payment engine has settled. For drivers
+// that own their clients, such as replay; unlike network sessions, these
+// may also run operator commands (CLOCK).
+bool executeCommand(ClientState& client, std::string_view line, std::ostream& body);
+
+// The directory that file names given to commands (EXPORT file=, IMPORT,
+// TRACE DUMP) are resolved in; clients are untrusted, so only relative
+// names that stay inside it are accepted. Empty, the default, turns file
+// access off. Set it before serving.
+void setProtocolDataDir(const std::string& dir);
+
+// While set, every request a session receives is appended to `log` as
+// "@<session> <line>", which replay accepts. nullptr stops recording.
+void recordCommands(std::ostream* log);
+
+#endif // PROTOCOL_H
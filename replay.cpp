@@ -0,0 +1,148 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "client_state.h"
+#include "latency_histogram.h"
+#include "ledger.h"
+#include "protocol.h"
+#include "report_writer.h"
+
+using namespace std;
+
+namespace {
+
+struct ScriptLine {
+    int client;
+    size_t op;        // index into the per-operation stats
+    string request;
+};
+
+struct OpStats {
+    string name;
+    uint64_t count = 0;
+    uint64_t errors = 0;
+    uint64_t totalNanos = 0;
+    LatencyHistogram nanos;
+
+    explicit OpStats(string name) : name(std::move(name)) {}
+};
+
+string_view trim(string_view s) {
+    while (!s.empty() && isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+    while (!s.empty() && isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+    return s;
+}
+
+// Parses the script once, up front, so replay time is spent executing.
+bool loadScript(const string& path, vector<ScriptLine>& script, deque<OpStats>& ops) {
+    ifstream in(path);
+    if (!in) return false;
+
+    unordered_map<string, size_t> opIndex;
+    string raw;
+    while (getline(in, raw)) {
+        string_view line = trim(raw);
+        if (line.empty() || line.front() == '#') continue;
+
+        int client = 0;
+        if (line.front() == '@') {
+            size_t end = 1;
+            while (end < line.size() && isdigit(static_cast<unsigned char>(line[end]))) {
+                client = client * 10 + (line[end] - '0');
+                ++end;
+            }
+            line = trim(line.substr(end));
+            if (line.empty()) continue;
+        }
+
+        string name(line.substr(0, min(line.find(' '), line.size())));
+        for (char& c : name) c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+        auto [it, added] = opIndex.emplace(name, ops.size());
+        if (added) ops.emplace_back(name);
+        script.push_back({client, it->second, string(line)});
+    }
+    return true;
+}
+
+double micros(uint64_t nanos) { return static_cast<double>(nanos) / 1000.0; }
+
+} // namespace
+
+int runReplay(const ReplayOptions& options, ostream& report) {
+    vector<ScriptLine> script;
+    deque<OpStats> ops;
+    if (!loadScript(options.path, script, ops)) {
+        report << "Replay: cannot read " << options.path << endl;
+        return 1;
+    }
+
+    unordered_map<int, ClientState> clients;
+    ReportStats reportsBefore = reportStats();
+    ostringstream body;
+    body << fixed << setprecision(2);
+
+    auto started = chrono::steady_clock::now();
+    for (int pass = 0; pass < options.repeat; ++pass) {
+        for (const ScriptLine& line : script) {
+            body.str("");
+            auto t0 = chrono::steady_clock::now();
+            bool ok = executeCommand(clients[line.client], line.request, body);
+            auto nanos = static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count());
+
+            OpStats& op = ops[line.op];
+            ++op.count;
+            if (!ok) ++op.errors;
+            op.totalNanos += nanos;
+            op.nanos.record(nanos);
+
+            if (options.echo) {
+                string_view text = body.view();
+                report << (ok ? "OK " : "ERR ") << text.size() << "\n" << text;
+            }
+        }
+    }
+    syncLedger();
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+    ReportStats reportsAfter = reportStats();
+    uint64_t reportRows = reportsAfter.rows - reportsBefore.rows;
+    double reportSeconds = reportsAfter.seconds - reportsBefore.seconds;
+
+    uint64_t total = 0;
+    for (const OpStats& op : ops) total += op.count;
+
+    vector<const OpStats*> byTime;
+    for (const OpStats& op : ops) byTime.push_back(&op);
+    sort(byTime.begin(), byTime.end(), [](const OpStats* a, const OpStats* b) { return a->totalNanos > b->totalNanos; });
+
+    report << fixed << setprecision(2);
+    report << "\n--- REPLAY: " << options.path << " (x" << options.repeat << ") ---" << endl;
+    report << "Requests: " << total << " in " << elapsed << " s ("
+           << (elapsed > 0 ? static_cast<double>(total) / elapsed : 0.0) << " requests/s)" << endl;
+    if (reportRows > 0) {
+        report << "Report rows: " << reportRows << " rendered at "
+               << (reportSeconds > 0 ? static_cast<double>(reportRows) / reportSeconds : 0.0) << " rows/s" << endl;
+    }
+    report << left << setw(14) << "Op" << right << setw(10) << "Count" << setw(8) << "Errors"
+           << setw(11) << "Mean us" << setw(11) << "p50 us" << setw(11) << "p99 us" << setw(12) << "Total ms" << endl;
+    for (const OpStats* op : byTime) {
+        report << left << setw(14) << op->name << right << setw(10) << op->count << setw(8) << op->errors
+               << setw(11) << micros(op->totalNanos) / static_cast<double>(op->count)
+               << setw(11) << micros(op->nanos.percentile(0.50))
+               << setw(11) << micros(op->nanos.percentile(0.99))
+               << setw(12) << micros(op->totalNanos) / 1000.0 << endl;
+    }
+    report << "-------------------------------------------------------------------------------" << endl;
+    return 0;
+}
@@ -0,0 +1,24 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <ostream>
+#include <string>
+
+// Headless driver: executes a script of protocol requests (protocol.h)
+// straight against the store, with no prompts, sessions or sockets, and
+// reports how long each kind of request took.
+//
+// One request per line. Blank lines and lines starting with '#' are
+// skipped. A line may start with "@<n> " to act as client n; each client
+// keeps its own login and cart. Logs written by recordCommands() replay
+// as-is.
+struct ReplayOptions {
+    std::string path;
+    int repeat = 1;      // run the script this many times
+    bool echo = false;   // print every reply as the server would frame it
+};
+
+// Returns 0 on success, 1 if the script could not be read.
+int runReplay(const ReplayOptions& options, std::ostream& report);
+
+#endif // REPLAY_H
@@ -0,0 +1,100 @@
+#include "report_writer.h"
+
+#include <atomic>
+#include <charconv>
+#include <ctime>
+
+using namespace std;
+
+namespace {
+
+struct HourCache {
+    time_t start = 0;
+    time_t end = 0;        // empty until the first call
+    char prefix[14];       // "YYYY-MM-DD HH:"
+};
+
+thread_local HourCache hourCache;
+
+atomic<uint64_t> renderedRows{0};
+atomic<uint64_t> renderNanos{0};
+
+void putDigits(char* out, int value, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+} // namespace
+
+void formatTimestamp(chrono::system_clock::time_point when, char* out) {
+    time_t tt = chrono::system_clock::to_time_t(when);
+    HourCache& cache = hourCache;
+    if (tt < cache.start || tt >= cache.end) {
+        struct tm local;
+        localtime_r(&tt, &local);
+        cache.start = tt - (local.tm_min * 60 + local.tm_sec);
+        cache.end = cache.start + 3600;
+        putDigits(cache.prefix, local.tm_year + 1900, 4);
+        cache.prefix[4] = '-';
+        putDigits(cache.prefix + 5, local.tm_mon + 1, 2);
+        cache.prefix[7] = '-';
+        putDigits(cache.prefix + 8, local.tm_mday, 2);
+        cache.prefix[10] = ' ';
+        putDigits(cache.prefix + 11, local.tm_hour, 2);
+        cache.prefix[13] = ':';
+    }
+    int intoHour = static_cast<int>(tt - cache.start);
+    memcpy(out, cache.prefix, sizeof(cache.prefix));
+    putDigits(out + 14, intoHour / 60, 2);
+    out[16] = ':';
+    putDigits(out + 17, intoHour % 60, 2);
+}
+
+ReportStats reportStats() {
+    ReportStats stats;
+    stats.rows = renderedRows.load(memory_order_relaxed);
+    stats.seconds = static_cast<double>(renderNanos.load(memory_order_relaxed)) / 1e9;
+    if (stats.seconds > 0) stats.rowsPerSecond = static_cast<double>(stats.rows) / stats.seconds;
+    return stats;
+}
+
+ReportWriter::ReportWriter(ostream& out) : out(out), started(chrono::steady_clock::now()) {}
+
+ReportWriter::~ReportWriter() {
+    flush();
+    auto nanos = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - started).count();
+    renderedRows.fetch_add(rows, memory_order_relaxed);
+    renderNanos.fetch_add(static_cast<uint64_t>(nanos), memory_order_relaxed);
+}
+
+void ReportWriter::flush() {
+    if (used == 0) return;
+    out.write(buffer, static_cast<streamsize>(used));
+    used = 0;
+}
+
+void ReportWriter::writeInteger(long long value) {
+    reserve(kMaxNumber);
+    used = static_cast<size_t>(to_chars(buffer + used, buffer + kBufferSize, value).ptr - buffer);
+}
+
+void ReportWriter::writeUnsigned(unsigned long long value) {
+    reserve(kMaxNumber);
+    used = static_cast<size_t>(to_chars(buffer + used, buffer + kBufferSize, value).ptr - buffer);
+}
+
+ReportWriter& ReportWriter::operator<<(Money money) {
+    reserve(kMaxNumber);
+    auto result = to_chars(buffer + used, buffer + kBufferSize, money.value, chars_format::fixed, 2);
+    used = static_cast<size_t>(result.ptr - buffer);
+    return *this;
+}
+
+ReportWriter& ReportWriter::operator<<(Timestamp stamp) {
+    reserve(kTimestampLength);
+    formatTimestamp(stamp.when, buffer + used);
+    used += kTimestampLength;
+    return *this;
+}
@@ -0,0 +1,100 @@
+#ifndef REPORT_WRITER_H
+#define REPORT_WRITER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string_view>
+#include <type_traits>
+
+// Length of a formatted timestamp, "YYYY-MM-DD HH:MM:SS".
+constexpr std::size_t kTimestampLength = 19;
+
+// Writes `when` in local time to `out` (kTimestampLength chars, no NUL).
+// Safe to call from any thread. Each thread caches the "YYYY-MM-DD HH:"
+// prefix of the last local hour it formatted, so a run of rows in time
+// order needs no localtime_r call. The cache covers an hour rather than a
+// day because daylight-saving changes happen on the hour.
+void formatTimestamp(std::chrono::system_clock::time_point when, char* out);
+
+// Rendering throughput across every ReportWriter since startup.
+struct ReportStats {
+    std::uint64_t rows = 0;
+    double seconds = 0;
+    double rowsPerSecond = 0;
+};
+ReportStats reportStats();
+
+// Buffered writer for long reports. It gathers output in a large buffer
+// and hands it to the stream in big blocks, never flushing per line.
+// Numbers are formatted with to_chars, with no locale and no stream
+// state. Whatever is still buffered is written when the writer goes out
+// of scope, and its rows and time are added to reportStats().
+class ReportWriter {
+public:
+    struct Money { double value; };   // fixed, two decimals
+    struct Timestamp { std::chrono::system_clock::time_point when; };
+
+private:
+    static constexpr std::size_t kBufferSize = 64 * 1024;
+    // Enough for any double in fixed notation with two decimals.
+    static constexpr std::size_t kMaxNumber = 320;
+
+    std::ostream& out;
+    std::size_t used = 0;
+    std::uint64_t rows = 0;
+    std::chrono::steady_clock::time_point started;
+    char buffer[kBufferSize];
+
+    void reserve(std::size_t n) { if (kBufferSize - used < n) flush(); }
+    void writeInteger(long long value);
+    void writeUnsigned(unsigned long long value);
+
+public:
+    explicit ReportWriter(std::ostream& out);
+    ~ReportWriter();
+
+    ReportWriter(const ReportWriter&) = delete;
+    ReportWriter& operator=(const ReportWriter&) = delete;
+
+    ReportWriter& operator<<(std::string_view text) {
+        if (text.size() > kBufferSize - used) {
+            flush();
+            if (text.size() > kBufferSize) {
+                out.write(text.data(), static_cast<std::streamsize>(text.size()));
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, text.data(), text.size());
+        used += text.size();
+        return *this;
+    }
+    ReportWriter& operator<<(const char* text) { return *this << std::string_view(text); }
+    ReportWriter& operator<<(char c) {
+        reserve(1);
+        buffer[used++] = c;
+        return *this;
+    }
+    template <typename T>
+        requires(std::is_integral_v<T> && !std::is_same_v<T, char> && !std::is_same_v<T, bool>)
+    ReportWriter& operator<<(T value) {
+        if constexpr (std::is_signed_v<T>) writeInteger(value);
+        else writeUnsigned(value);
+        return *this;
+    }
+    ReportWriter& operator<<(Money money);
+    ReportWriter& operator<<(Timestamp stamp);
+
+    // Ends the current line and counts it as one row of the report.
+    void endRow() {
+        *this << '\n';
+        ++rows;
+    }
+
+    // Hands everything buffered to the stream (without flushing the stream).
+    void flush();
+};
+
+#endif // REPORT_WRITER_H
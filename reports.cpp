@@ -0,0 +1,439 @@
+#include "reports.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+#include "approx_analytics.h"
+#include "clock.h"
+#include "ledger.h"
+#include "metrics.h"
+#include "parallel_scan.h"
+#include "report_writer.h"
+#include "store.h"
+
+using namespace std;
+
+using Money = ReportWriter::Money;
+using Stamp = ReportWriter::Timestamp;
+
+// A requested list length as a size; zero or negative asks for nothing.
+static size_t listLength(int n) { return n > 0 ? static_cast<size_t>(n) : 0; }
+
+static void writeCashFlowRows(const vector<size_t>& rows, ostream& out) {
+    ReportWriter w(out);
+    for (size_t i : rows) {
+        const CashFlowLog& flow = cashFlows[i];
+        w << '[' << Stamp{flow.getTimestamp()} << "] " << flow.getType() << " $" << Money{flow.getAmount()}
+          << " - " << flow.getDescription();
+        w.endRow();
+    }
+}
+
+int listStoreItems(ostream& out) {
+    MetricTimer timer(Metric::REPORT_STORE_ITEMS);
+    out << "ID | Name | Seller | Price | Stock" << endl;
+    out << "---|------|--------|-------|------" << endl;
+    int displayCount = 0;
+    shared_lock<shared_mutex> lock(inventoryMutex);
+    for (const auto& store : sellers) {
+        for (const auto& item : store.getItems()) {
+            if (item.isDisplayed()) {
+                out << item.getId() << " | " << item.getName() << " | "
+                    << store.sellerName << " | $" << item.getPrice() << " | "
+                    << item.getQuantity() << endl;
+                displayCount++;
+            }
+        }
+    }
+    return displayCount;
+}
+
+void checkSpendingLastKDays(const Buyer& buyer, int k, ostream& out) {
+    MetricTimer timer(Metric::REPORT_SPENDING);
+    if (k <= 0) { out << "K must be positive." << endl; return; }
+    syncLedger();
+
+    RowFilter debits;
+    debits.since = toLedgerTime(clockNow() - chrono::hours(24 * k));
+    debits.id = buyer.getAccount().getId();
+    debits.flag = kDebitFlag;
+    double totalSpending = sumRows(cashFlowColumns, debits);
+
+    out << "\n--- SPENDING ANALYSIS (LAST " << k << " DAYS) ---" << endl;
+    writeCashFlowRows(selectRows(cashFlowColumns, debits), out);
+
+    out << "---------------------------------------" << endl;
+    out << "Total Debit Spending: $" << totalSpending << endl;
+}
+
+void listCashFlowToday(const BankCustomer& account, ostream& out) {
+    MetricTimer timer(Metric::REPORT_CASH_FLOW);
+    syncLedger();
+    auto today_start = clockStartOfDay();
+
+    RowFilter today;
+    today.since = toLedgerTime(today_start);
+    today.id = account.getId();
+
+    out << "\n--- CASH FLOW: TODAY ---" << endl;
+    auto rows = selectRows(cashFlowColumns, today);
+    writeCashFlowRows(rows, out);
+    if (rows.empty()) out << "No cash flow recorded today." << endl;
+    out << "------------------------" << endl;
+}
+
+void listCashFlowLastMonth(const BankCustomer& account, ostream& out) {
+    MetricTimer timer(Metric::REPORT_CASH_FLOW);
+    syncLedger();
+    RowFilter lastMonth;
+    lastMonth.since = toLedgerTime(clockNow() - chrono::hours(24 * 30));
+    lastMonth.id = account.getId();
+
+    out << "\n--- CASH FLOW: LAST MONTH ---" << endl;
+    auto rows = selectRows(cashFlowColumns, lastMonth);
+    writeCashFlowRows(rows, out);
+    if (rows.empty()) out << "No cash flow recorded in the last month." << endl;
+    out << "-----------------------------" << endl;
+}
+
+void discoverTopItemsPerMonth(const seller& store, int k, ostream& out) {
+    MetricTimer timer(Metric::REPORT_TOP_ITEMS);
+    syncLedger();
+    auto month_ago = clockNow() - chrono::hours(24 * 30);
+    int sellerId = store.getId();
+    auto sortedItems = parallelTopK<string>(ledgerSnapshot().transactions, listLength(k),
+        [](const Transaction& t) { return t.getItemName(); },
+        [&](const Transaction& t) { return t.getTimestamp() >= month_ago && t.getSellerId() == sellerId; });
+
+    out << "\n--- TOP " << k << " POPULAR ITEMS (LAST MONTH) ---" << endl;
+    if (sortedItems.empty()) { out << "No sales data found this month." << endl; return; }
+
+    for (size_t i = 0; i < sortedItems.size(); ++i) {
+        out << i + 1 << ". " << sortedItems[i].second
+             << " (" << sortedItems[i].first << " transactions)" << endl;
+    }
+    out << "------------------------------------------------" << endl;
+}
+
+// The approximate reports copy what they print out of analyticsSketches
+// and release its mutex before looking up names and writing rows, so a
+// slow reader does not stall observe() on the order path.
+
+template <typename Key>
+struct ApproxTop {
+    vector<typename SpaceSaving<Key>::Entry> rows;   // count: the tighter of both estimates
+    double errorBound = 0;
+    double confidence = 0;
+};
+
+// Call with analyticsSketches.mutex held.
+template <typename Key>
+static ApproxTop<Key> approxTop(const SpaceSaving<Key>& heavy, const CountMinSketch& frequency, size_t k) {
+    ApproxTop<Key> result{heavy.top(k), frequency.errorBound(), frequency.confidence()};
+    for (auto& row : result.rows) row.count = min<uint64_t>(row.count, frequency.estimate(sketchHash(row.key)));
+    return result;
+}
+
+static void discoverLoyalCustomerPerMonthApprox(const seller& store, ostream& out) {
+    vector<SpaceSaving<int>::Entry> topBuyers;
+    double distinctBuyers = 0;
+    double distinctError = 0;
+    {
+        lock_guard<mutex> lock(analyticsSketches.mutex);
+        auto it = analyticsSketches.sellers.find(store.getId());
+        if (it != analyticsSketches.sellers.end()) {
+            const SellerSketch& sketch = it->second;
+            topBuyers = sketch.recentBuyers(sketchDay(clockNow()), SellerSketch::kWindowDays).top(5);
+            distinctBuyers = sketch.distinctBuyers.estimate();
+            distinctError = sketch.distinctBuyers.relativeError();
+        }
+    }
+
+    out << "\n--- LOYAL CUSTOMERS (LAST MONTH, APPROXIMATE) ---" << endl;
+    if (topBuyers.empty()) { out << "No loyal customers found this month." << endl; return; }
+
+    for (size_t i = 0; i < topBuyers.size(); ++i) {
+        string name = "Unknown";
+        if (Buyer* b = findBuyer(topBuyers[i].key)) { name = b->getName(); }
+
+        out << i + 1 << ". ID " << topBuyers[i].key << " (" << name << ") - ~"
+             << topBuyers[i].count << " total orders (over-count <= " << topBuyers[i].error << ")" << endl;
+    }
+    out << "Distinct buyers (all time): ~" << static_cast<long long>(distinctBuyers)
+         << " (+/- " << 100.0 * distinctError << "%)" << endl;
+    out << "-------------------------------------" << endl;
+}
+
+void discoverLoyalCustomerPerMonth(const seller& store, ostream& out) {
+    MetricTimer timer(Metric::REPORT_LOYAL_CUSTOMERS);
+    syncLedger();
+    if (approximateAnalytics) { discoverLoyalCustomerPerMonthApprox(store, out); return; }
+
+    auto month_ago = clockNow() - chrono::hours(24 * 30);
+    int sellerId = store.getId();
+    auto sortedBuyers = parallelTopK<int>(ledgerSnapshot().transactions, 5,
+        [](const Transaction& t) { return t.getBuyerId(); },
+        [&](const Transaction& t) { return t.getTimestamp() >= month_ago && t.getSellerId() == sellerId; });
+
+    out << "\n--- LOYAL CUSTOMERS (LAST MONTH) ---" << endl;
+    if (sortedBuyers.empty()) { out << "No loyal customers found this month." << endl; return; }
+
+    for (size_t i = 0; i < sortedBuyers.size(); ++i) {
+        int buyerId = sortedBuyers[i].second;
+        int count = sortedBuyers[i].first;
+
+        string name = "Unknown";
+        if (Buyer* b = findBuyer(buyerId)) { name = b->getName(); }
+
+        out << i + 1 << ". ID " << buyerId << " (" << name << ") - "
+             << count << " total orders" << endl;
+    }
+    out << "-------------------------------------" << endl;
+}
+
+void listRecentTransactions(int k, ostream& out) {
+    MetricTimer timer(Metric::REPORT_RECENT);
+    syncLedger();
+    if (k <= 0) { out << "K must be positive." << endl; return; }
+
+    RowFilter recent;
+    recent.since = toLedgerTime(clockNow() - chrono::hours(24 * k));
+    auto matches = selectRows(transactionColumns, recent);
+
+    out << "\n--- TRANSACTIONS OF LAST " << k << " DAYS ---" << endl;
+    {
+        ReportWriter w(out);
+        for (size_t i : matches) {
+            const Transaction& t = allTransactions[i];
+            w << "ID: " << t.getId()
+              << ", Buyer: " << t.getBuyerId()
+              << ", Seller: " << t.getSellerId()
+              << ", Item: " << t.getItemName()
+              << ", Amount: $" << Money{t.getAmount()}
+              << ", Status: " << t.getStatusString();
+            w.endRow();
+        }
+    }
+    if (matches.empty()) out << "No transactions found in the last " << k << " days." << endl;
+}
+
+void listUncompletedTransactions(ostream& out) {
+    MetricTimer timer(Metric::REPORT_UNCOMPLETED);
+    syncLedger();
+    auto transactions = ledgerSnapshot().transactions;
+    auto matches = parallelFilter(transactions,
+        [](const Transaction& t) { return t.getStatus() == Transaction::PAID; });
+
+    out << "\n--- PAID BUT UNCOMPLETED TRANSACTIONS ---" << endl;
+    {
+        ReportWriter w(out);
+        for (size_t i : matches) {
+            const Transaction& t = transactions[i];
+            w << "ID: " << t.getId()
+              << ", Buyer: " << t.getBuyerId()
+              << ", Seller: " << t.getSellerId()
+              << ", Item: " << t.getItemName()
+              << ", Amount: $" << Money{t.getAmount()};
+            w.endRow();
+        }
+    }
+    if (matches.empty()) out << "No uncompleted transactions found." << endl;
+}
+
+static void listMostFrequentItemsApprox(int m, ostream& out) {
+    ApproxTop<string> topItems;
+    size_t tracked;
+    {
+        lock_guard<mutex> lock(analyticsSketches.mutex);
+        topItems = approxTop(analyticsSketches.topItems, analyticsSketches.itemFrequency, listLength(m));
+        tracked = analyticsSketches.topItems.getCapacity();
+    }
+
+    out << "\n--- TOP " << m << " MOST FREQUENT ITEMS (All Time, APPROXIMATE) ---" << endl;
+    for (size_t i = 0; i < topItems.rows.size(); ++i) {
+        out << i + 1 << ". " << topItems.rows[i].key
+             << " (~" << topItems.rows[i].count << " transactions)" << endl;
+    }
+    if (listLength(m) > tracked) {
+        out << "(only the " << tracked << " heaviest items are tracked)" << endl;
+    }
+    out << "Counts over-estimate by at most " << topItems.errorBound
+         << " (" << 100.0 * topItems.confidence << "% confidence)." << endl;
+}
+
+void listMostFrequentItems(int m, ostream& out) {
+    MetricTimer timer(Metric::REPORT_FREQUENT_ITEMS);
+    syncLedger();
+    if (approximateAnalytics) { listMostFrequentItemsApprox(m, out); return; }
+
+    auto sortedItems = parallelTopK<string>(ledgerSnapshot().transactions, listLength(m),
+        [](const Transaction& t) { return t.getItemName(); });
+
+    out << "\n--- TOP " << m << " MOST FREQUENT ITEMS (All Time) ---" << endl;
+    for (size_t i = 0; i < sortedItems.size(); ++i) {
+        out << i + 1 << ". " << sortedItems[i].second
+             << " (" << sortedItems[i].first << " transactions)" << endl;
+    }
+}
+
+static void listMostActiveUsersApprox(const string& type, const ApproxTop<int>& topUsers, ostream& out) {
+    out << "\n--- MOST ACTIVE " << type << " (Total Transactions, APPROXIMATE) ---" << endl;
+    for (size_t i = 0; i < topUsers.rows.size(); ++i) {
+        int userId = topUsers.rows[i].key;
+        uint64_t estimate = topUsers.rows[i].count;
+
+        string name = "Unknown";
+        if (Buyer* b = findBuyer(userId)) { name = b->getName(); }
+
+        out << i + 1 << ". ID " << userId << " (" << name << ") - ~"
+             << estimate << " transactions\n";
+    }
+    out << "Counts over-estimate by at most " << topUsers.errorBound
+         << " (" << 100.0 * topUsers.confidence << "% confidence)." << endl;
+}
+
+template <typename KeyFn>
+static void listMostActiveUsers(const string& type, KeyFn userKey, ostream& out) {
+    auto sortedUsers = parallelTopK<int>(ledgerSnapshot().transactions, 5, userKey);
+
+    out << "\n--- MOST ACTIVE " << type << " (Total Transactions) ---" << endl;
+    for (size_t i = 0; i < sortedUsers.size(); ++i) {
+        int userId = sortedUsers[i].second;
+        int count = sortedUsers[i].first;
+
+        string name = "Unknown";
+        if (Buyer* b = findBuyer(userId)) { name = b->getName(); }
+
+        out << i + 1 << ". ID " << userId << " (" << name << ") - "
+             << count << " transactions\n";
+    }
+}
+
+void listMostActiveBuyers(ostream& out) {
+    MetricTimer timer(Metric::REPORT_ACTIVE_BUYERS);
+    syncLedger();
+    if (approximateAnalytics) {
+        ApproxTop<int> topUsers;
+        {
+            lock_guard<mutex> lock(analyticsSketches.mutex);
+            topUsers = approxTop(analyticsSketches.topBuyers, analyticsSketches.buyerFrequency, 5);
+        }
+        listMostActiveUsersApprox("BUYERS", topUsers, out);
+        return;
+    }
+    listMostActiveUsers("BUYERS", [](const Transaction& t) { return t.getBuyerId(); }, out);
+}
+
+void listMostActiveSellers(ostream& out) {
+    MetricTimer timer(Metric::REPORT_ACTIVE_SELLERS);
+    syncLedger();
+    if (approximateAnalytics) {
+        ApproxTop<int> topUsers;
+        {
+            lock_guard<mutex> lock(analyticsSketches.mutex);
+            topUsers = approxTop(analyticsSketches.topSellers, analyticsSketches.sellerFrequency, 5);
+        }
+        listMostActiveUsersApprox("SELLERS", topUsers, out);
+        return;
+    }
+    listMostActiveUsers("SELLERS", [](const Transaction& t) { return t.getSellerId(); }, out);
+}
+
+void showPaymentStats(ostream& out) {
+    PaymentStats stats = paymentEngine().stats();
+    out << "\n--- PAYMENT PIPELINE STATISTICS ---" << endl;
+    out << "Completed: " << stats.completed << ", Failed: " << stats.failed << endl;
+    out << "Batches: " << stats.batches << " (mean size " << stats.meanBatchSize << ")" << endl;
+    out << "Throughput: " << stats.throughputPerSecond << " payments/s" << endl;
+    out << "Latency p50: " << stats.p50Micros << " us, p99: " << stats.p99Micros << " us" << endl;
+    out << "-----------------------------------" << endl;
+}
+
+void showReportStats(ostream& out) {
+    ReportStats stats = reportStats();
+    out << "\n--- REPORT RENDERING STATISTICS ---" << endl;
+    out << "Rows: " << stats.rows << " in " << stats.seconds << " s" << endl;
+    out << "Throughput: " << stats.rowsPerSecond << " rows/s" << endl;
+    out << "-----------------------------------" << endl;
+}
+
+void printAccountCreated(const BankCustomer& account, ostream& out) {
+    out << "Bank: Account created for " << account.getName()
+        << " with ID: " << account.getId() << endl;
+}
+
+void printBalanceChange(const char* operation, TransferStatus status, const BankCustomer* account, ostream& out) {
+    switch (status) {
+        case TransferStatus::OK:
+            out << "Bank: " << operation << " successful. New balance: $" << fixed << setprecision(2)
+                << account->getBalance() << "\n";
+            break;
+        case TransferStatus::ACCOUNT_NOT_FOUND:
+            out << "Bank: " << operation << " failed: Account not found.\n";
+            break;
+        case TransferStatus::INSUFFICIENT_FUNDS:
+            out << "Bank: " << operation << " failed due to insufficient funds.\n";
+            break;
+        default:
+            out << "Bank: " << operation << " failed: " << transferStatusString(status) << ".\n";
+            break;
+    }
+}
+
+void printCustomerInfo(int accountId, ostream& out) {
+    const BankCustomer* account = myBank.findCustomerByIdOrNull(accountId);
+    if (!account) {
+        out << "Bank: Account not found.\n";
+        return;
+    }
+    account->printInfo(out);
+}
+
+static void printAccountRows(const vector<AccountSummary>& rows, ostream& out) {
+    for (const AccountSummary& row : rows) {
+        out << "ID " << row.id << ": " << row.name
+            << " (Balance: $" << fixed << setprecision(2) << row.balance << ")\n";
+    }
+}
+
+void listAllCustomers(ostream& out) {
+    MetricTimer timer(Metric::REPORT_CUSTOMERS);
+    auto rows = myBank.customers();
+    out << "\n--- LIST OF ALL BANK CUSTOMERS (" << rows.size() << ") ---" << endl;
+    printAccountRows(rows, out);
+    out << "---------------------------------------------------" << endl;
+}
+
+void listDormantAccounts(ostream& out) {
+    MetricTimer timer(Metric::REPORT_DORMANT);
+    auto rows = myBank.dormantAccounts();
+    out << "\n--- LIST OF DORMANT ACCOUNTS (" << rows.size() << ") ---" << endl;
+    if (rows.empty()) {
+        out << "No dormant accounts found." << endl;
+    } else {
+        printAccountRows(rows, out);
+    }
+    out << "------------------------------------------" << endl;
+}
+
+void listTopUsersToday(int n, ostream& out) {
+    MetricTimer timer(Metric::REPORT_TOP_USERS);
+    auto busiest = myBank.topUsersToday(n);
+    out << "\n--- TOP " << n << " ACTIVE USERS TODAY (By Activity Count) ---" << endl;
+    if (busiest.empty()) {
+        out << "No transaction activity found today." << endl;
+        return;
+    }
+    for (size_t i = 0; i < busiest.size(); ++i) {
+        string name = "Unknown";
+        if (const Buyer* b = findBuyer(busiest[i].id)) name = b->getName();
+
+        out << i + 1 << ". ID " << busiest[i].id << " (" << name << ") - "
+            << busiest[i].count << " activities\n";
+    }
+    out << "---------------------------------------------------" << endl;
+}
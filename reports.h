@@ -0,0 +1,45 @@
+#ifndef REPORTS_H
+#define REPORTS_H
+
+#include <ostream>
+
+#include "bank.h"
+#include "bank_customer.h"
+#include "buyer.h"
+#include "seller.h"
+
+// Read-only reports shared by the console menus and the command protocol.
+// Each writes its full text to `out`; none reads input.
+// Reports over the ledger call syncLedger() first, so they always see the
+// caller's own completed purchases.
+
+// Lists every visible item across all stores; returns how many were listed.
+int listStoreItems(ostream& out);
+
+void checkSpendingLastKDays(const Buyer& buyer, int k, ostream& out);
+void listCashFlowToday(const BankCustomer& account, ostream& out);
+void listCashFlowLastMonth(const BankCustomer& account, ostream& out);
+
+void discoverTopItemsPerMonth(const seller& store, int k, ostream& out);
+void discoverLoyalCustomerPerMonth(const seller& store, ostream& out);
+
+// Bank results. The bank itself never writes output, so these are the
+// only place its messages are formatted.
+void printAccountCreated(const BankCustomer& account, ostream& out);
+// `operation` is "Deposit" or "Withdraw"; prints the outcome of that call.
+void printBalanceChange(const char* operation, TransferStatus status, const BankCustomer* account, ostream& out);
+void printCustomerInfo(int accountId, ostream& out);
+void listAllCustomers(ostream& out);
+void listDormantAccounts(ostream& out);
+void listTopUsersToday(int n, ostream& out);
+
+void listRecentTransactions(int k, ostream& out);
+void listUncompletedTransactions(ostream& out);
+void listMostFrequentItems(int m, ostream& out);
+void listMostActiveBuyers(ostream& out);
+void listMostActiveSellers(ostream& out);
+void showPaymentStats(ostream& out);
+// Rows per second across the long listings above (report_writer.h).
+void showReportStats(ostream& out);
+
+#endif // REPORTS_H
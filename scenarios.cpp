@@ -0,0 +1,391 @@
+// End-to-end scenario benchmarks: whole user flows driven through the core
+// library by several threads at once, on a generated dataset.
+//
+//   scenarios [--scenario shopper|seller|admin|bank|all] [--threads N] [--seconds S]
+//             [--workload SPEC] [--save FILE] [--baseline FILE] [--tolerance PCT]
+//
+//   shopper  register, deposit, browse the catalog, add one to three items
+//            to a cart, check out and pay; one flow is one operation.
+//   seller   a random store runs its monthly reports: top items, loyal
+//            customers and the last month's cash flow.
+//   admin    one thread runs the bank analysis reports back to back while
+//            the other threads keep paying for orders; both sides are
+//            reported, so report cost and its effect on payments show up.
+//   bank     deposits, withdrawals and two-leg transfers between a small
+//            pool of accounts, so threads contend on the same balances.
+//            Afterwards the pool's total must equal its opening total plus
+//            what was deposited less what was withdrawn, and no balance may
+//            be negative; if not, the run exits with status 3.
+//
+// Each scenario prints ops/s, p50/p99/p999 latency and the process peak RSS
+// so far. --save writes the results as JSON lines; --baseline reads such a
+// file and compares, exiting with status 2 if throughput fell or p99 rose
+// by more than --tolerance percent (default 10).
+//
+// --workload takes the workload.h spec, default
+// "accounts=5000,sellers=50,itemsPerSeller=100,events=100000".
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ledger.h"
+#include "reports.h"
+#include "store.h"
+#include "workload.h"
+
+using namespace std;
+
+namespace {
+
+struct Options {
+    string scenario = "all";
+    int threads = 4;
+    double seconds = 3.0;
+    string workload = "accounts=5000,sellers=50,itemsPerSeller=100,events=100000";
+    string savePath;
+    string baselinePath;
+    double tolerance = 10.0;
+};
+
+struct Result {
+    string name;
+    int threads = 0;
+    uint64_t ops = 0;
+    double opsPerSecond = 0;
+    double p50 = 0, p99 = 0, p999 = 0;   // microseconds
+    long peakRssKb = 0;
+};
+
+// Swallows report text so only the work of producing it is measured.
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+long peakRssKb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// The state one worker thread keeps between flows.
+struct Worker {
+    mt19937_64 random;
+    NullBuffer nullBuffer;
+    ostream sink{&nullBuffer};
+    Buyer* buyer = nullptr;
+    vector<uint32_t> latencies;   // nanoseconds, one per flow
+
+    explicit Worker(uint64_t seed) : random(seed) {}
+
+    int pick(int lo, int hi) { return uniform_int_distribution<int>(lo, hi)(random); }
+};
+
+using Flow = function<void(Worker&)>;
+
+// Runs `flow` on `threads` workers until `seconds` have passed.
+Result measure(const string& name, int threads, double seconds, const Flow& flow,
+               const function<void(Worker&)>& setup = nullptr) {
+    vector<unique_ptr<Worker>> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.push_back(make_unique<Worker>(static_cast<uint64_t>(t) + 1));
+        if (setup) setup(*workers.back());
+    }
+
+    auto deadline = chrono::steady_clock::now() + chrono::duration<double>(seconds);
+    auto started = chrono::steady_clock::now();
+    vector<thread> pool;
+    for (auto& w : workers) {
+        pool.emplace_back([&, worker = w.get()] {
+            while (chrono::steady_clock::now() < deadline) {
+                auto begin = chrono::steady_clock::now();
+                flow(*worker);
+                auto nanos = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - begin).count();
+                worker->latencies.push_back(static_cast<uint32_t>(min<int64_t>(nanos, UINT32_MAX)));
+            }
+        });
+    }
+    for (thread& t : pool) t.join();
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+    vector<uint32_t> all;
+    for (auto& w : workers) all.insert(all.end(), w->latencies.begin(), w->latencies.end());
+    sort(all.begin(), all.end());
+    auto percentile = [&](double p) {
+        if (all.empty()) return 0.0;
+        size_t at = min(all.size() - 1, static_cast<size_t>(p * static_cast<double>(all.size())));
+        return all[at] / 1000.0;
+    };
+
+    Result r;
+    r.name = name;
+    r.threads = threads;
+    r.ops = all.size();
+    r.opsPerSecond = static_cast<double>(all.size()) / elapsed;
+    r.p50 = percentile(0.50);
+    r.p99 = percentile(0.99);
+    r.p999 = percentile(0.999);
+    r.peakRssKb = peakRssKb();
+    return r;
+}
+
+// Fills a cart with one to three visible, stocked items and pays for it.
+void buyAndPay(Worker& w) {
+    BankCustomer& account = w.buyer->getAccount();
+    myBank.deposit(account.getId(), 500.0);
+
+    vector<OrderItem> cart;
+    {
+        shared_lock<shared_mutex> lock(inventoryMutex);
+        int items = itemIdCounter.load();
+        for (int n = w.pick(1, 3); n > 0; --n) {
+            seller* itemSeller = nullptr;
+            Item* item = findItemInStore(w.pick(1, items), itemSeller);
+            if (!item || !item->isDisplayed() || !item->checkAvailability(1)) continue;
+            cart.push_back({item->getId(), item->getName(), item->getPrice(), 1, itemSeller->getId()});
+        }
+    }
+    if (cart.empty()) return;
+
+    Order invoice(++orderIdCounter, w.buyer->getId());
+    for (const OrderItem& line : cart) {
+        invoice.addItem(line.itemId, line.itemName, line.price, line.quantity, line.sellerId);
+    }
+    Order& order = w.buyer->addOrder(std::move(invoice));
+    PaymentResult result = paymentEngine().submit(paymentRequestFor(order, *w.buyer)).get();
+    if (result.status == TransferStatus::OK) {
+        lock_guard<mutex> lock(w.buyer->getOrdersMutex());
+        order.markAsPaid();
+    }
+}
+
+void registerBuyer(Worker& w) {
+    static atomic<int> registered{0};
+    string name = "scenario-" + to_string(++registered);
+    BankCustomer& account = myBank.createAccount(name, 0.0);
+    w.buyer = &addBuyer(name, account);
+}
+
+void shopperFlow(Worker& w) {
+    registerBuyer(w);
+    listStoreItems(w.sink);
+    buyAndPay(w);
+}
+
+void sellerFlow(Worker& w) {
+    seller& store = sellers[static_cast<size_t>(w.pick(0, static_cast<int>(sellers.size()) - 1))];
+    syncLedger();
+    discoverTopItemsPerMonth(store, 5, w.sink);
+    discoverLoyalCustomerPerMonth(store, w.sink);
+    listCashFlowLastMonth(store.getAccount(), w.sink);
+}
+
+// Accounts the bank scenario works on; few enough that threads collide.
+constexpr int kBankAccounts = 64;
+constexpr double kBankOpeningBalance = 1000.0;
+vector<int> bankAccounts;
+// Deposits less withdrawals, in whole dollars so double sums stay exact.
+atomic<long long> bankNetDeposits{0};
+
+void openBankAccounts() {
+    for (int i = 0; i < kBankAccounts; ++i) {
+        string name = "bank-stress-" + to_string(i + 1);
+        bankAccounts.push_back(myBank.createAccount(name, kBankOpeningBalance).getId());
+    }
+}
+
+void bankFlow(Worker& w) {
+    int from = bankAccounts[static_cast<size_t>(w.pick(0, kBankAccounts - 1))];
+    int to = bankAccounts[static_cast<size_t>(w.pick(0, kBankAccounts - 1))];
+    int amount = w.pick(1, 100);
+    switch (w.pick(0, 2)) {
+        case 0:
+            if (myBank.deposit(from, amount) == TransferStatus::OK) bankNetDeposits += amount;
+            break;
+        case 1:
+            if (myBank.withdraw(from, amount) == TransferStatus::OK) bankNetDeposits -= amount;
+            break;
+        default:
+            myBank.transfer({{TransferLeg::DEBIT, from, static_cast<double>(amount), "Stress transfer"},
+                             {TransferLeg::CREDIT, to, static_cast<double>(amount), "Stress transfer"}});
+    }
+}
+
+// Checks that the bank scenario neither created nor lost money.
+bool bankConserved() {
+    double expected = kBankAccounts * kBankOpeningBalance + static_cast<double>(bankNetDeposits.load());
+    double total = 0;
+    bool negative = false;
+    for (int id : bankAccounts) {
+        double balance = myBank.findCustomerById(id).getBalance();
+        total += balance;
+        negative = negative || balance < 0;
+    }
+    cout << "bank: total " << fixed << setprecision(2) << total << ", expected " << expected
+         << (negative ? ", NEGATIVE BALANCE" : "") << endl;
+    return total == expected && !negative;
+}
+
+// The reports behind the console's bank analysis menu.
+void adminFlow(Worker& w) {
+    syncLedger();
+    listRecentTransactions(7, w.sink);
+    listAllCustomers(w.sink);
+    listDormantAccounts(w.sink);
+    listTopUsersToday(5, w.sink);
+}
+
+// Payments with one admin reporting alongside. The admin side runs on its
+// own thread so the two are measured separately.
+vector<Result> runAdmin(const Options& opt) {
+    Result reports;
+    thread admin([&] { reports = measure("admin.reports", 1, opt.seconds, adminFlow); });
+    Result payments = measure("admin.payments", max(opt.threads - 1, 1), opt.seconds, buyAndPay, registerBuyer);
+    admin.join();
+    return {reports, payments};
+}
+
+void print(const Result& r) {
+    cout << left << setw(16) << r.name << right << " " << setw(2) << r.threads << " threads  " << fixed
+         << setprecision(0) << setw(9) << r.opsPerSecond << " ops/s  p50 " << setprecision(1) << setw(9) << r.p50
+         << " us  p99 " << setw(9) << r.p99 << " us  p999 " << setw(9) << r.p999 << " us  peak RSS "
+         << r.peakRssKb / 1024 << " MiB" << endl;
+}
+
+string toJson(const Result& r) {
+    ostringstream line;
+    line << fixed << setprecision(1) << "{\"scenario\":\"" << r.name << "\",\"threads\":" << r.threads
+         << ",\"ops\":" << r.ops << ",\"ops_per_sec\":" << r.opsPerSecond << ",\"p50_us\":" << r.p50
+         << ",\"p99_us\":" << r.p99 << ",\"p999_us\":" << r.p999 << ",\"peak_rss_kb\":" << r.peakRssKb << "}";
+    return line.str();
+}
+
+// Reads the number after "key": in one of our own JSON lines.
+double jsonNumber(const string& line, const string& key) {
+    size_t at = line.find("\"" + key + "\":");
+    return at == string::npos ? 0.0 : strtod(line.c_str() + at + key.size() + 3, nullptr);
+}
+
+string jsonName(const string& line) {
+    size_t at = line.find("\"scenario\":\"");
+    if (at == string::npos) return "";
+    at += 12;
+    return line.substr(at, line.find('"', at) - at);
+}
+
+// Compares against a --save file; returns false if anything regressed.
+bool compare(const vector<Result>& results, const Options& opt) {
+    ifstream file(opt.baselinePath);
+    if (!file) {
+        cerr << "cannot read baseline " << opt.baselinePath << endl;
+        return false;
+    }
+    map<string, string> baseline;
+    for (string line; getline(file, line);) {
+        if (!line.empty()) baseline[jsonName(line)] = line;
+    }
+
+    bool ok = true;
+    cout << "\nAgainst " << opt.baselinePath << " (tolerance " << opt.tolerance << "%):" << endl;
+    for (const Result& r : results) {
+        auto found = baseline.find(r.name);
+        if (found == baseline.end()) {
+            cout << "  " << left << setw(16) << r.name << " not in baseline" << endl;
+            continue;
+        }
+        double oldOps = jsonNumber(found->second, "ops_per_sec");
+        double oldP99 = jsonNumber(found->second, "p99_us");
+        double opsChange = oldOps > 0 ? (r.opsPerSecond / oldOps - 1) * 100 : 0;
+        double p99Change = oldP99 > 0 ? (r.p99 / oldP99 - 1) * 100 : 0;
+        bool regressed = opsChange < -opt.tolerance || p99Change > opt.tolerance;
+        ok = ok && !regressed;
+        cout << "  " << left << setw(16) << r.name << right << showpos << fixed << setprecision(1) << setw(8)
+             << opsChange << "% ops/s " << setw(8) << p99Change << "% p99" << noshowpos
+             << (regressed ? "  REGRESSION" : "") << endl;
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string flag = argv[i];
+        if (flag == "--scenario") opt.scenario = argv[i + 1];
+        else if (flag == "--threads") opt.threads = max(1, atoi(argv[i + 1]));
+        else if (flag == "--seconds") opt.seconds = atof(argv[i + 1]);
+        else if (flag == "--workload") opt.workload = argv[i + 1];
+        else if (flag == "--save") opt.savePath = argv[i + 1];
+        else if (flag == "--baseline") opt.baselinePath = argv[i + 1];
+        else if (flag == "--tolerance") opt.tolerance = atof(argv[i + 1]);
+        else {
+            cerr << "unknown option " << flag << endl;
+            return 1;
+        }
+    }
+    bool known = opt.scenario == "all" || opt.scenario == "shopper" || opt.scenario == "seller" ||
+                 opt.scenario == "admin" || opt.scenario == "bank";
+    WorkloadOptions workload;
+    if (argc % 2 == 0 || !known || !parseWorkloadSpec(opt.workload, workload)) {
+        cerr << "usage: scenarios [--scenario shopper|seller|admin|bank|all] [--threads N] [--seconds S]\n"
+                "                 [--workload SPEC] [--save FILE] [--baseline FILE] [--tolerance PCT]"
+             << endl;
+        return 1;
+    }
+
+    WorkloadSummary generated = generateWorkload(workload);
+    cout << "Dataset: " << generated.accounts << " accounts, " << generated.items << " items, "
+         << ledgerSnapshot().transactions.size() << " transactions" << endl;
+    if (sellers.size() == 0 || itemIdCounter.load() == 0) {
+        cerr << "the workload needs at least one seller with items" << endl;
+        return 1;
+    }
+
+    vector<Result> results;
+    auto want = [&](const char* name) { return opt.scenario == "all" || opt.scenario == name; };
+    if (want("shopper")) results.push_back(measure("shopper", opt.threads, opt.seconds, shopperFlow));
+    if (want("seller")) results.push_back(measure("seller", opt.threads, opt.seconds, sellerFlow));
+    if (want("admin")) {
+        for (Result& r : runAdmin(opt)) results.push_back(r);
+    }
+    bool conserved = true;
+    if (want("bank")) {
+        openBankAccounts();
+        results.push_back(measure("bank", opt.threads, opt.seconds, bankFlow));
+        conserved = bankConserved();
+    }
+    for (const Result& r : results) print(r);
+
+    if (!opt.savePath.empty()) {
+        ofstream save(opt.savePath);
+        for (const Result& r : results) save << toJson(r) << "\n";
+        if (!save) {
+            cerr << "cannot write " << opt.savePath << endl;
+            return 1;
+        }
+    }
+    if (!conserved) return 3;
+    if (!opt.baselinePath.empty() && !compare(results, opt)) return 2;
+    return 0;
+}
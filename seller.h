@@ -2,15 +2,26 @@
 #include "buyer.h"
 #include "item.h"
 #include <string>
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <memory_resource>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 class seller : public Buyer { 
 
 public: 
     std::string sellerName;
-    std::vector<Item> items; 
+    // A deque so adding an item never moves the others. It and the index
+    // are charged to the inventory subsystem (memory_accounting.h).
+    std::pmr::deque<Item> items{memoryResource(MemoryTag::INVENTORY)};
 
 private:
+    // Item id -> its entry in `items`.
+    std::pmr::unordered_map<int, Item*> itemIndex{memoryResource(MemoryTag::INVENTORY)};
+
     bool idDisplayed(int itemId) const {
         return itemId > 0; 
     }
@@ -18,22 +29,40 @@ private:
 public:
     seller() = default;
 
-    seller(const Buyer& buyer, int sellerId, const std::string& sellerName)
+    // A seller shares its id with the buyer it was upgraded from.
+    seller(const Buyer& buyer, int /*sellerId*/, const std::string& sellerName)
         : Buyer(buyer.getId(), buyer.getName(), buyer.getAccount()), sellerName(sellerName) {
         }
 
+    // The index points into this seller's own deque.
+    seller(const seller&) = delete;
+    seller& operator=(const seller&) = delete;
+
     virtual ~seller() = default;
 
     void addNewItem(int newId, const std::string& newName, int newQuantity, double newPrice) {
-        Item newItem(newId, newName, newQuantity, newPrice);
-        items.push_back(newItem);
+        Item& item = items.emplace_back(newId, newName, newQuantity, newPrice);
+        itemIndex[newId] = &item;
     }
-    
-    Item* findItemById(int itemId) {
-        for (auto& item : items) {
-            if (item.getId() == itemId) return &item;
+
+    // Moves a batch of items, ids already set, into the store; the index
+    // is grown at most once for the whole batch, geometrically, so a long
+    // import rehashes only a logarithmic number of times.
+    void addItems(std::vector<Item>& batch) {
+        std::size_t needed = itemIndex.size() + batch.size();
+        if (static_cast<float>(needed) > static_cast<float>(itemIndex.bucket_count()) * itemIndex.max_load_factor()) {
+            itemIndex.reserve(std::max(needed, 2 * itemIndex.size()));
+        }
+        for (Item& item : batch) {
+            Item& added = items.emplace_back(std::move(item));
+            itemIndex.emplace(added.getId(), &added);
         }
-        return nullptr;
+        batch.clear();
+    }
+
+    Item* findItemById(int itemId) {
+        auto it = itemIndex.find(itemId);
+        return it == itemIndex.end() ? nullptr : it->second;
     }
 
     void setItemPrice(int itemId, double newPrice) {
@@ -58,21 +87,16 @@ public:
     }
 
     void updateItem(int itemId, const std::string& newName, int newQuantity, double newPrice) {
-        for (auto& item : items) {
-            if (item.getId() == itemId) {
-                item.alterItemById(itemId, newName, newQuantity, newPrice); 
-            }
+        if (Item* item = findItemById(itemId)) {
+            item->alterItemById(itemId, newName, newQuantity, newPrice); 
         }
     }
 
     void makeItemVisibleToCustomer(int itemId) {
-        for (auto& item : items) {
-            if (item.getId() == itemId) {
-                item.setDisplay(true); 
-                break;
-            }
+        if (Item* item = findItemById(itemId)) {
+            item->setDisplay(true); 
         }
     }
 
-    const std::vector<Item>& getItems() const { return items; }
+    const std::pmr::deque<Item>& getItems() const { return items; }
 };
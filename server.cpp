@@ -0,0 +1,287 @@
+#include "server.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+constexpr size_t kReadChunk = 64 * 1024;
+// Past this much unread input plus unsent output a connection stops being
+// read until the session and the client catch up, so neither a client
+// that pipelines without reading nor one that outpaces its session can
+// grow the server's buffers without bound. Reading resumes at half.
+constexpr size_t kMaxBacklog = 4 * 1024 * 1024;
+constexpr int kMaxEvents = 256;
+
+void systemError(const char* what) {
+    throw runtime_error(string("Server: ") + what + ": " + strerror(errno));
+}
+
+} // namespace
+
+LoopbackServer::LoopbackServer(SessionRuntime& runtime, uint16_t requestedPort) : runtime(runtime) {
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) systemError("socket");
+    int yes = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(requestedPort);
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) systemError("bind");
+    if (listen(listenFd, SOMAXCONN) < 0) systemError("listen");
+    socklen_t len = sizeof(addr);
+    getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &len);
+    port = ntohs(addr.sin_port);
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) systemError("epoll_create1");
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0) systemError("eventfd");
+
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    ev.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+}
+
+LoopbackServer::~LoopbackServer() {
+    for (auto& entry : connections) close(entry.first);
+    if (wakeFd >= 0) close(wakeFd);
+    if (epollFd >= 0) close(epollFd);
+    if (listenFd >= 0) close(listenFd);
+}
+
+void LoopbackServer::stop() {
+    stopping.store(true);
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t n = write(wakeFd, &one, sizeof(one));
+}
+
+void LoopbackServer::schedule(const shared_ptr<Connection>& c) {
+    {
+        lock_guard<mutex> lock(dirtyMutex);
+        dirty.push_back(c);
+    }
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t n = write(wakeFd, &one, sizeof(one));
+}
+
+void LoopbackServer::acceptAll() {
+    for (;;) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return;   // EAGAIN, or out of descriptors: retry on the next edge
+        }
+        int yes = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+        auto c = make_shared<Connection>(fd);
+        connections.emplace(fd, c);
+
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+
+        // The sink batches whatever the session wrote during one slice and
+        // wakes the loop only if the connection was not already pending.
+        c->session = runtime.open(
+            [this, c](string_view text) {
+                bool wake;
+                {
+                    lock_guard<mutex> lock(c->mutex);
+                    c->outbox.append(text);
+                    wake = !std::exchange(c->queued, true);
+                }
+                if (wake) schedule(c);
+            },
+            [this, c] {
+                {
+                    lock_guard<mutex> lock(c->mutex);
+                    c->finished = true;
+                    c->queued = true;
+                }
+                schedule(c);
+            },
+            // A paused connection is read again once its session has
+            // caught up, even if that produced no output to wake the loop.
+            [this, c] {
+                if (!c->readPaused.load()) return;
+                bool wake;
+                {
+                    lock_guard<mutex> lock(c->mutex);
+                    wake = !std::exchange(c->queued, true);
+                }
+                if (wake) schedule(c);
+            });
+        readAll(*c);
+    }
+}
+
+void LoopbackServer::readAll(Connection& c) {
+    char buffer[kReadChunk];
+    while (!c.readPaused) {
+        ssize_t n = recv(c.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            runtime.feed(c.session, string_view(buffer, static_cast<size_t>(n)));
+            if (backlog(c) > kMaxBacklog) {
+                // Paused before re-checking, so a session that catches up in
+                // between sees the flag and wakes the loop.
+                c.readPaused = true;
+                if (backlog(c) > kMaxBacklog / 2) return;
+                c.readPaused = false;
+            }
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        // Orderly shutdown: the session answers what it has read, then
+        // ends. A reset means nobody will read the answers.
+        if (n < 0) {
+            c.broken = true;
+            runtime.abandon(c.session);
+        } else {
+            runtime.close(c.session);
+        }
+        return;
+    }
+}
+
+size_t LoopbackServer::backlog(Connection& c) {
+    size_t pending = c.sending.size() - c.sent + runtime.backlog(c.session);
+    lock_guard<mutex> lock(c.mutex);
+    return pending + c.outbox.size();
+}
+
+void LoopbackServer::writeAll(Connection& c) {
+    {
+        lock_guard<mutex> lock(c.mutex);
+        if (c.sent == c.sending.size()) {
+            c.sending.clear();
+            c.sent = 0;
+            c.sending.swap(c.outbox);
+        } else {
+            c.sending.append(c.outbox);
+            c.outbox.clear();
+        }
+    }
+    if (c.broken) {
+        c.sending.clear();
+        c.sent = 0;
+        return;
+    }
+
+    while (c.sent < c.sending.size()) {
+        ssize_t n = send(c.fd, c.sending.data() + c.sent, c.sending.size() - c.sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            c.sent += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        c.broken = true;
+        c.sending.clear();
+        c.sent = 0;
+        runtime.abandon(c.session);
+        return;
+    }
+
+    if (c.readPaused && backlog(c) <= kMaxBacklog / 2) {
+        c.readPaused = false;
+        readAll(c);
+    }
+}
+
+void LoopbackServer::release(Connection& c) {
+    c.released = true;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, c.fd, nullptr);
+    close(c.fd);
+    connections.erase(c.fd);
+}
+
+void LoopbackServer::flush(Connection& c) {
+    // Read first: output the session wrote before finishing is then in the
+    // outbox that writeAll takes.
+    bool finished;
+    {
+        lock_guard<mutex> lock(c.mutex);
+        finished = c.finished;
+    }
+    writeAll(c);
+    if (finished && c.sent == c.sending.size()) release(c);
+}
+
+void LoopbackServer::drainDirty() {
+    vector<shared_ptr<Connection>> ready;
+    {
+        lock_guard<mutex> lock(dirtyMutex);
+        ready.swap(dirty);
+    }
+    for (const auto& c : ready) {
+        if (c->released) continue;
+        {
+            lock_guard<mutex> lock(c->mutex);
+            c->queued = false;
+        }
+        flush(*c);
+    }
+}
+
+void LoopbackServer::run() {
+    epoll_event events[kMaxEvents];
+    bool draining = false;
+    for (;;) {
+        if (stopping.load() && !draining) {
+            draining = true;
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, listenFd, nullptr);
+            vector<shared_ptr<Connection>> open;
+            for (auto& entry : connections) open.push_back(entry.second);
+            for (const auto& c : open) {
+                c->broken = true;
+                runtime.abandon(c->session);
+                // A session that already ended may only be waiting for a
+                // client that stopped reading; nothing else would close it.
+                flush(*c);
+            }
+        }
+        if (draining && connections.empty()) return;
+
+        int n = epoll_wait(epollFd, events, kMaxEvents, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            systemError("epoll_wait");
+        }
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listenFd) {
+                acceptAll();
+            } else if (fd == wakeFd) {
+                uint64_t count;
+                [[maybe_unused]] ssize_t r = read(wakeFd, &count, sizeof(count));
+            } else {
+                auto it = connections.find(fd);
+                if (it == connections.end()) continue;
+                shared_ptr<Connection> c = it->second;
+                if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) readAll(*c);
+                if ((events[i].events & EPOLLOUT) && !c->released) flush(*c);
+            }
+        }
+        drainDirty();
+    }
+}
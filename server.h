@@ -0,0 +1,83 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "session.h"
+
+// Serves the command protocol (protocol.h) on a loopback TCP port. One
+// thread runs an edge-triggered epoll loop that only moves bytes: each
+// connection gets its own session on `runtime`, which parses and executes
+// the requests on the runtime's pool. Replies are handed back to the loop
+// and written in whatever batches the socket accepts.
+class LoopbackServer {
+private:
+    struct Connection {
+        int fd;
+        int session = 0;
+
+        // Shared with the session's sink, which runs on pool threads.
+        std::mutex mutex;
+        std::string outbox;
+        bool finished = false;   // session ended; close once everything is sent
+        bool queued = false;     // already on the dirty list
+
+        // Set by the loop thread, read by the session's waiting callback.
+        std::atomic<bool> readPaused{false};   // too far behind; stop reading
+
+        // Loop thread only.
+        std::string sending;
+        std::size_t sent = 0;
+        bool broken = false;     // peer gone; discard output
+        bool released = false;   // descriptor closed
+
+        explicit Connection(int fd) : fd(fd) {}
+    };
+
+    SessionRuntime& runtime;
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;
+    std::uint16_t port = 0;
+    std::atomic<bool> stopping{false};
+
+    std::unordered_map<int, std::shared_ptr<Connection>> connections;
+
+    std::mutex dirtyMutex;
+    std::vector<std::shared_ptr<Connection>> dirty;
+
+    void acceptAll();
+    void readAll(Connection& c);
+    std::size_t backlog(Connection& c);
+    void writeAll(Connection& c);
+    // writeAll, then release if the session has ended and all of it is sent.
+    void flush(Connection& c);
+    void schedule(const std::shared_ptr<Connection>& c);
+    void drainDirty();
+    void release(Connection& c);
+
+public:
+    // Binds 127.0.0.1:port; port 0 picks a free one. Throws on failure.
+    LoopbackServer(SessionRuntime& runtime, std::uint16_t port);
+    ~LoopbackServer();
+
+    LoopbackServer(const LoopbackServer&) = delete;
+    LoopbackServer& operator=(const LoopbackServer&) = delete;
+
+    std::uint16_t getPort() const { return port; }
+
+    // Serves until stop(), then ends every connection's session and
+    // returns once they have all finished.
+    void run();
+    // Safe from any thread and from a signal handler.
+    void stop();
+};
+
+#endif // SERVER_H
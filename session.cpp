@@ -0,0 +1,260 @@
+#include "session.h"
+
+#include <cctype>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+// Past this many consumed bytes the input buffer is compacted.
+constexpr size_t kCompactAfter = 4096;
+// A session that keeps finding input never suspends, so it flushes its
+// output whenever this much has built up instead of only between slices.
+constexpr size_t kFlushAfter = 16 * 1024;
+
+bool isSpace(char c) { return isspace(static_cast<unsigned char>(c)) != 0; }
+
+} // namespace
+
+Session::Session(int id, Sink sink, SessionRuntime& runtime)
+    : ClientState(&arena), id(id), sink(std::move(sink)), runtime(runtime),
+      out(ios::out, pmr::polymorphic_allocator<char>(&arena)) {
+    out << fixed << setprecision(2);
+}
+
+bool Session::InputAwaiter::await_suspend(coroutine_handle<> h) {
+    if (session.out.view().size() >= kFlushAfter) session.flush();
+    session.unflushed.store(session.out.view().size(), memory_order_relaxed);
+    {
+        lock_guard<std::mutex> lock(session.mutex);
+        if (session.take(*this)) return false;
+        session.pending = this;
+        session.waiting = h;
+    }
+    // Input that arrives now only marks the session ready; it resumes after
+    // this slice, so the awaiter and the session are still alive here.
+    if (session.onWaiting) session.onWaiting();
+    return true;
+}
+
+void Session::dropLine() {
+    lock_guard<std::mutex> lock(mutex);
+    skipLine = true;
+}
+
+// Called with `mutex` held. True once `request` is answered: `got` says
+// whether it received input or the input has ended.
+bool Session::take(InputAwaiter& request) {
+    if (skipLine || (request.want == Want::LINE && afterToken)) {
+        size_t nl = input.find('\n', inputPos);
+        if (nl == string::npos) {
+            inputPos = input.size();
+            if (!inputClosed) return false;
+        } else {
+            inputPos = nl + 1;
+        }
+        skipLine = false;
+        afterToken = false;
+    }
+
+    size_t begin = inputPos, end = inputPos;
+    bool complete = false;
+    if (request.want == Want::TOKEN) {
+        while (begin < input.size() && isSpace(input[begin])) ++begin;
+        end = begin;
+        while (end < input.size() && !isSpace(input[end])) ++end;
+        complete = end < input.size() || (inputClosed && end > begin);
+        if (complete) {
+            request.text.assign(input, begin, end - begin);
+            inputPos = end;
+            afterToken = true;
+        }
+    } else {
+        size_t nl = input.find('\n', begin);
+        complete = nl != string::npos || (inputClosed && begin < input.size());
+        if (complete) {
+            end = nl == string::npos ? input.size() : nl;
+            request.text.assign(input, begin, end - begin);
+            if (!request.text.empty() && request.text.back() == '\r') request.text.pop_back();
+            inputPos = nl == string::npos ? end : nl + 1;
+        }
+    }
+
+    if (inputPos == input.size() || inputPos > kCompactAfter) {
+        input.erase(0, inputPos);
+        inputPos = 0;
+    }
+    request.got = complete;
+    return complete || inputClosed;
+}
+
+void Session::wake(coroutine_handle<> h) {
+    unique_lock<std::mutex> lock(mutex);
+    ready = h;
+    if (!running) {
+        running = true;
+        lock.unlock();
+        runtime.post(*this);
+    }
+}
+
+void Session::flush() {
+    string_view text = out.view();
+    if (text.empty()) return;
+    if (sink) sink(text);
+    out.str(pmr::string(&arena));
+    unflushed.store(0, memory_order_relaxed);
+}
+
+SessionRuntime::SessionRuntime(Entry entry, size_t threads)
+    : entry(std::move(entry)), pool(threads ? threads : thread::hardware_concurrency()) {}
+
+SessionRuntime::~SessionRuntime() {
+    vector<int> ids;
+    {
+        lock_guard<mutex> lock(sessionsMutex);
+        for (const auto& s : sessions) ids.push_back(s.first);
+    }
+    for (int id : ids) close(id);
+    waitAll();
+}
+
+shared_ptr<Session> SessionRuntime::find(int id) const {
+    lock_guard<mutex> lock(sessionsMutex);
+    auto it = sessions.find(id);
+    return it == sessions.end() ? nullptr : it->second;
+}
+
+int SessionRuntime::open(Session::Sink sink, function<void()> onFinish, function<void()> onWaiting) {
+    shared_ptr<Session> session;
+    {
+        lock_guard<mutex> lock(sessionsMutex);
+        int id = ++nextId;
+        session = make_shared<Session>(id, std::move(sink), *this);
+        session->onFinish = std::move(onFinish);
+        session->onWaiting = std::move(onWaiting);
+        sessions.emplace(id, session);
+    }
+    session->main = entry(*session);
+    session->wake(session->main.coroutine());
+    return session->getId();
+}
+
+void SessionRuntime::feed(int id, string_view text) {
+    shared_ptr<Session> session = find(id);
+    if (!session) return;
+    coroutine_handle<> resume;
+    {
+        lock_guard<mutex> lock(session->mutex);
+        session->input.append(text);
+        if (session->pending && session->take(*session->pending)) {
+            resume = session->waiting;
+            session->pending = nullptr;
+            session->waiting = {};
+        }
+    }
+    if (resume) session->wake(resume);
+}
+
+size_t SessionRuntime::backlog(int id) const {
+    shared_ptr<Session> session = find(id);
+    if (!session) return 0;
+    lock_guard<mutex> lock(session->mutex);
+    return session->input.size() - session->inputPos + session->unflushed.load(memory_order_relaxed);
+}
+
+void SessionRuntime::close(int id) {
+    endInput(id, false);
+}
+
+void SessionRuntime::abandon(int id) {
+    endInput(id, true);
+}
+
+void SessionRuntime::endInput(int id, bool discard) {
+    shared_ptr<Session> session = find(id);
+    if (!session) return;
+    coroutine_handle<> resume;
+    {
+        lock_guard<mutex> lock(session->mutex);
+        if (discard) {
+            session->input.clear();
+            session->inputPos = 0;
+        }
+        session->inputClosed = true;
+        if (session->pending && session->take(*session->pending)) {
+            resume = session->waiting;
+            session->pending = nullptr;
+            session->waiting = {};
+        }
+    }
+    if (resume) session->wake(resume);
+}
+
+void SessionRuntime::post(Session& session) {
+    pool.submit([this, keep = session.shared_from_this()] { runSlice(*keep); });
+}
+
+void SessionRuntime::runSlice(Session& session) {
+    for (;;) {
+        coroutine_handle<> h;
+        {
+            lock_guard<mutex> lock(session.mutex);
+            h = std::exchange(session.ready, nullptr);
+            if (!h) {
+                session.running = false;
+                session.idle.notify_all();
+                return;
+            }
+        }
+
+        h.resume();
+        session.flush();
+
+        if (session.main.done()) {
+            try {
+                session.main.result();
+            } catch (const SessionClosed&) {
+            } catch (const exception& e) {
+                cerr << "Session " << session.getId() << " ended: " << e.what() << endl;
+            }
+            retire(session);
+            return;
+        }
+    }
+}
+
+void SessionRuntime::retire(Session& session) {
+    {
+        lock_guard<mutex> lock(session.mutex);
+        session.finished = true;
+        session.running = false;
+    }
+    session.idle.notify_all();
+    if (session.onFinish) session.onFinish();
+
+    lock_guard<mutex> lock(sessionsMutex);
+    sessions.erase(session.getId());
+    if (sessions.empty()) allFinished.notify_all();
+}
+
+bool SessionRuntime::waitForPrompt(int id) {
+    shared_ptr<Session> session = find(id);
+    if (!session) return false;
+    unique_lock<mutex> lock(session->mutex);
+    session->idle.wait(lock, [&] { return session->finished || (!session->running && session->pending); });
+    return !session->finished;
+}
+
+void SessionRuntime::waitAll() {
+    unique_lock<mutex> lock(sessionsMutex);
+    allFinished.wait(lock, [this] { return sessions.empty(); });
+}
+
+size_t SessionRuntime::activeSessions() const {
+    lock_guard<mutex> lock(sessionsMutex);
+    return sessions.size();
+}
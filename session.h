@@ -0,0 +1,215 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "client_state.h"
+#include "payment_engine.h"
+#include "task.h"
+#include "thread_pool.h"
+
+class SessionRuntime;
+
+// Thrown out of a pending read when the session's input has ended; it
+// unwinds the menus and finishes the session.
+struct SessionClosed : std::runtime_error {
+    SessionClosed() : std::runtime_error("session input closed") {}
+};
+
+namespace session_detail {
+
+// Per-session memory: the output buffer and the cart draw from it, so one
+// session's churn never touches another's allocations. Unsynchronised, so
+// only the thread running the session may use it; the input buffer, which
+// the feeding thread appends to, stays on the default heap. A base class
+// so it is built before, and destroyed after, everything using it.
+struct Arena {
+    std::pmr::unsynchronized_pool_resource arena;
+};
+
+} // namespace session_detail
+
+// One connected user: who is logged in, their cart, and buffered console
+// I/O. Menus run as coroutines on the session and suspend (instead of
+// blocking a thread) whenever they need input or wait for a payment.
+//
+// Input mirrors `cin`: read() takes the next whitespace-separated token and
+// readLine() the next full line, discarding the rest of a line that a
+// token was read from. A token that does not parse is dropped with the
+// rest of its line, like the usual cin.clear()/ignore() recovery.
+class Session : private session_detail::Arena, public ClientState, public std::enable_shared_from_this<Session> {
+public:
+    using OutStream = std::basic_ostringstream<char, std::char_traits<char>, std::pmr::polymorphic_allocator<char>>;
+    using Sink = std::function<void(std::string_view)>;
+
+private:
+    enum class Want { TOKEN, LINE };
+
+    struct InputAwaiter {
+        Session& session;
+        Want want;
+        std::string text;   // filled by whichever thread answers the read
+        bool got = false;
+
+        InputAwaiter(Session& s, Want want) : session(s), want(want) {}
+        bool await_ready() { return false; }
+        bool await_suspend(std::coroutine_handle<> h);
+        void requireInput() const { if (!got) throw SessionClosed(); }
+    };
+
+    template <typename T>
+    struct ReadAwaiter : InputAwaiter {
+        T& target;
+
+        ReadAwaiter(Session& s, T& target) : InputAwaiter(s, Want::TOKEN), target(target) {}
+        bool await_resume() {
+            requireInput();
+            std::istringstream parse{text};
+            if (parse >> target) return true;
+            session.dropLine();
+            return false;
+        }
+    };
+
+    struct LineAwaiter : InputAwaiter {
+        std::string& target;
+
+        LineAwaiter(Session& s, std::string& target) : InputAwaiter(s, Want::LINE), target(target) {}
+        void await_resume() {
+            requireInput();
+            target.assign(text.begin(), text.end());
+        }
+    };
+
+    struct PaymentAwaiter {
+        Session& session;
+        PaymentEngine& engine;
+        PaymentRequest request;
+        PaymentResult result;
+
+        bool await_ready() { return false; }
+        void await_suspend(std::coroutine_handle<> h) {
+            engine.submit(std::move(request), [this, h](const PaymentResult& r) {
+                result = r;
+                session.wake(h);
+            });
+        }
+        PaymentResult await_resume() { return std::move(result); }
+    };
+
+    friend class SessionRuntime;
+
+    int id;
+    Sink sink;
+    std::function<void()> onFinish;
+    std::function<void()> onWaiting;
+    // Bytes written to `out` but not yet flushed, as of the last read.
+    std::atomic<std::size_t> unflushed{0};
+    SessionRuntime& runtime;
+
+    mutable std::mutex mutex;
+    std::condition_variable idle;
+    std::string input;
+    std::size_t inputPos = 0;
+    bool inputClosed = false;
+    bool afterToken = false;   // a token was taken and its line not finished
+    bool skipLine = false;     // drop input up to the next newline first
+    InputAwaiter* pending = nullptr;
+    std::coroutine_handle<> waiting;
+    std::coroutine_handle<> ready;
+    bool running = false;
+    bool finished = false;
+
+    Task<> main;
+
+    bool take(InputAwaiter& request);
+    void dropLine();
+    void wake(std::coroutine_handle<> h);
+
+public:
+    OutStream out;
+
+    Session(int id, Sink sink, SessionRuntime& runtime);
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    int getId() const { return id; }
+
+    // co_await read(x): false if the token did not parse as T.
+    template <typename T>
+    ReadAwaiter<T> read(T& target) { return ReadAwaiter<T>(*this, target); }
+    LineAwaiter readLine(std::string& target) { return LineAwaiter(*this, target); }
+    // co_await pay(engine, request): resumes with the result, no thread blocked.
+    PaymentAwaiter pay(PaymentEngine& engine, PaymentRequest request) {
+        return PaymentAwaiter{*this, engine, std::move(request), {}};
+    }
+
+    // Sends everything written to `out` so far to the session's sink.
+    void flush();
+};
+
+// Runs many sessions over a small thread pool. A session occupies a thread
+// only while its menus are computing; a session waiting for input holds
+// just its coroutine frames and buffers. Each session is resumed by at
+// most one thread at a time.
+class SessionRuntime {
+public:
+    using Entry = std::function<Task<>(Session&)>;
+
+private:
+    Entry entry;
+    mutable std::mutex sessionsMutex;
+    std::condition_variable allFinished;
+    std::unordered_map<int, std::shared_ptr<Session>> sessions;
+    int nextId = 0;
+    // Last, so its threads are joined before anything they use is destroyed.
+    ThreadPool pool;
+
+    friend class Session;
+    // Runs the session's ready coroutine on the pool. Caller has set
+    // `running` under the session's lock.
+    void post(Session& session);
+    void runSlice(Session& session);
+    void retire(Session& session);
+    void endInput(int id, bool discard);
+    std::shared_ptr<Session> find(int id) const;
+
+public:
+    explicit SessionRuntime(Entry entry, std::size_t threads = 0);
+    ~SessionRuntime();
+
+    // Starts a session; its output goes to `sink`, which is called from
+    // pool threads but never concurrently for the same session. `onFinish`
+    // runs once the session has ended and sent its last output;
+    // `onWaiting` each time it has used up its input and waits for more.
+    int open(Session::Sink sink, std::function<void()> onFinish = {}, std::function<void()> onWaiting = {});
+    void feed(int id, std::string_view text);
+    // Input fed but not yet read plus output not yet flushed to the sink,
+    // for a feeder that must stop before a session falls too far behind.
+    std::size_t backlog(int id) const;
+    // End of input: a pending read throws SessionClosed.
+    void close(int id);
+    // Like close(), but also drops input not yet read, for a peer that
+    // has gone away and will never see the replies.
+    void abandon(int id);
+    // Blocks until session `id` is waiting for input or has finished;
+    // returns false once it has finished.
+    bool waitForPrompt(int id);
+    void waitAll();
+    std::size_t activeSessions() const;
+};
+
+#endif // SESSION_H
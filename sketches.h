@@ -0,0 +1,172 @@
+#ifndef SKETCHES_H
+#define SKETCHES_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// splitmix64 finaliser: turns std::hash output (identity for ints) into
+// well-mixed 64-bit values for the sketches below.
+inline uint64_t mixHash(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+template <typename Key>
+inline uint64_t sketchHash(const Key& key) {
+    return mixHash(static_cast<uint64_t>(std::hash<Key>{}(key)));
+}
+
+// Count-min sketch. With width w and depth d, estimate(x) never
+// under-counts, and over-counts by at most (e / w) * total() with
+// probability 1 - exp(-d).
+class CountMinSketch {
+private:
+    std::size_t width;
+    std::size_t depth;
+    std::vector<uint32_t> cells;
+    uint64_t totalCount;
+
+    std::size_t cell(std::size_t row, uint64_t h) const {
+        // Double hashing: row i uses h1 + i * h2.
+        uint64_t h1 = h & 0xFFFFFFFFULL;
+        uint64_t h2 = (h >> 32) | 1;
+        return row * width + static_cast<std::size_t>((h1 + row * h2) % width);
+    }
+
+public:
+    CountMinSketch(std::size_t width = 2048, std::size_t depth = 4)
+        : width(width), depth(depth), cells(width * depth, 0), totalCount(0) {}
+
+    void add(uint64_t h, uint32_t count = 1) {
+        for (std::size_t r = 0; r < depth; ++r) cells[cell(r, h)] += count;
+        totalCount += count;
+    }
+
+    uint32_t estimate(uint64_t h) const {
+        uint32_t best = UINT32_MAX;
+        for (std::size_t r = 0; r < depth; ++r) best = std::min(best, cells[cell(r, h)]);
+        return best;
+    }
+
+    uint64_t total() const { return totalCount; }
+    // Additive error bound that holds with probability 1 - exp(-depth).
+    double errorBound() const { return std::exp(1.0) / static_cast<double>(width) * static_cast<double>(totalCount); }
+    double confidence() const { return 1.0 - std::exp(-static_cast<double>(depth)); }
+};
+
+// HyperLogLog distinct counter with 2^precision one-byte registers.
+// Relative standard error is about 1.04 / sqrt(2^precision).
+class HyperLogLog {
+private:
+    unsigned precision;
+    std::vector<uint8_t> registers;
+
+public:
+    explicit HyperLogLog(unsigned precision = 10) : precision(precision), registers(std::size_t{1} << precision, 0) {}
+
+    void add(uint64_t h) {
+        std::size_t idx = static_cast<std::size_t>(h >> (64 - precision));
+        uint64_t rest = (h << precision) | (uint64_t{1} << (precision - 1));
+        uint8_t rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+        registers[idx] = std::max(registers[idx], rank);
+    }
+
+    double estimate() const {
+        double m = static_cast<double>(registers.size());
+        double sum = 0.0;
+        std::size_t zeros = 0;
+        for (uint8_t r : registers) {
+            sum += std::ldexp(1.0, -r);
+            zeros += (r == 0);
+        }
+        double alpha = 0.7213 / (1.0 + 1.079 / m);
+        double raw = alpha * m * m / sum;
+        if (raw <= 2.5 * m && zeros > 0) {
+            return m * std::log(m / static_cast<double>(zeros));
+        }
+        return raw;
+    }
+
+    double relativeError() const { return 1.04 / std::sqrt(static_cast<double>(registers.size())); }
+};
+
+// Space-saving heavy hitters over at most `capacity` keys. Any key whose
+// true count exceeds total / capacity is tracked; a reported count
+// over-estimates the true count by at most that entry's `error`.
+template <typename Key>
+class SpaceSaving {
+public:
+    struct Entry {
+        Key key;
+        uint64_t count;
+        uint64_t error;
+    };
+
+private:
+    std::size_t capacity;
+    std::vector<Entry> entries;
+    std::unordered_map<Key, std::size_t> index;
+    uint64_t totalCount;
+
+public:
+    explicit SpaceSaving(std::size_t capacity = 64) : capacity(capacity), totalCount(0) {
+        entries.reserve(capacity);
+        index.reserve(capacity);
+    }
+
+    void add(const Key& key, uint64_t count = 1) {
+        totalCount += count;
+        auto it = index.find(key);
+        if (it != index.end()) {
+            entries[it->second].count += count;
+            return;
+        }
+        if (entries.size() < capacity) {
+            index.emplace(key, entries.size());
+            entries.push_back({key, count, 0});
+            return;
+        }
+        auto victim = std::min_element(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) { return a.count < b.count; });
+        index.erase(victim->key);
+        index.emplace(key, static_cast<std::size_t>(victim - entries.begin()));
+        victim->error = victim->count;
+        victim->count += count;
+        victim->key = key;
+    }
+
+    // Adds another summary's counters into this one (used to combine
+    // time buckets); the error bound becomes the sum of both bounds.
+    void merge(const SpaceSaving& other) {
+        for (const auto& e : other.entries) {
+            add(e.key, e.count);
+            entries[index[e.key]].error += e.error;
+        }
+    }
+
+    // Heaviest tracked keys first, ties broken by the larger key.
+    std::vector<Entry> top(std::size_t k) const {
+        std::vector<Entry> sorted = entries;
+        std::sort(sorted.begin(), sorted.end(), [](const Entry& a, const Entry& b) {
+            return a.count != b.count ? a.count > b.count : b.key < a.key;
+        });
+        if (sorted.size() > k) sorted.resize(k);
+        return sorted;
+    }
+
+    uint64_t total() const { return totalCount; }
+    std::size_t getCapacity() const { return capacity; }
+    bool empty() const { return entries.empty(); }
+};
+
+#endif // SKETCHES_H
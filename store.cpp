@@ -0,0 +1,124 @@
+#include "store.h"
+
+#include <algorithm>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+#include "memory_accounting.h"
+#include "metrics.h"
+#include "trace.h"
+
+using namespace std;
+
+Bank myBank("Global Commerce Bank");
+
+AppendLog<Buyer> buyers(memoryResource(MemoryTag::BUYERS));
+AppendLog<seller> sellers(memoryResource(MemoryTag::SELLERS));
+
+shared_mutex inventoryMutex;
+
+atomic<int> buyerIdCounter{0};
+atomic<int> itemIdCounter{0};
+atomic<int> transactionIdCounter{0};
+atomic<int> orderIdCounter{0};
+
+// Item id -> the seller stocking it. Ids come from one counter, so this is
+// a dense table; guarded by inventoryMutex like the items themselves.
+static pmr::vector<seller*> itemOwners(memoryResource(MemoryTag::INVENTORY));
+
+// Account id -> the buyer holding it, dense like itemOwners.
+static shared_mutex buyerIndexMutex;
+static pmr::vector<Buyer*> buyerByAccount(memoryResource(MemoryTag::BUYERS));
+
+Buyer& addBuyer(const string& name, BankCustomer& account) {
+    Buyer& buyer = buyers.emplace_back(++buyerIdCounter, name, account);
+    size_t slot = static_cast<size_t>(account.getId());
+    unique_lock<shared_mutex> lock(buyerIndexMutex);
+    if (buyerByAccount.size() <= slot) buyerByAccount.resize(max(slot + 1, buyerByAccount.size() * 2), nullptr);
+    buyerByAccount[slot] = &buyer;
+    return buyer;
+}
+
+Buyer* findBuyerByAccount(int accountId) {
+    shared_lock<shared_mutex> lock(buyerIndexMutex);
+    if (accountId <= 0 || static_cast<size_t>(accountId) >= buyerByAccount.size()) return nullptr;
+    return buyerByAccount[static_cast<size_t>(accountId)];
+}
+
+Buyer* findBuyerByEmail(string_view email) {
+    BankCustomer* account = myBank.findCustomerByEmail(email);
+    return account ? findBuyerByAccount(account->getId()) : nullptr;
+}
+
+Buyer* findBuyer(int id) {
+    TRACE_SPAN("findBuyer");
+    for (auto& b : buyers) {
+        if (b.getId() == id) return &b;
+    }
+    return nullptr;
+}
+
+seller* findSeller(int buyerId) {
+    TRACE_SPAN("findSeller");
+    for (auto& s : sellers) {
+        if (s.getId() == buyerId) return &s; 
+    }
+    return nullptr;
+}
+
+seller* addSeller(Buyer& owner, const string& storeName) {
+    unique_lock<shared_mutex> lock(inventoryMutex);
+    if (findSeller(owner.getId())) return nullptr;
+    return &sellers.emplace_back(owner, owner.getId(), storeName);
+}
+
+seller* findSellerByItem(int itemId) {
+    if (itemId <= 0 || static_cast<size_t>(itemId) >= itemOwners.size()) return nullptr;
+    return itemOwners[static_cast<size_t>(itemId)];
+}
+
+Item* findItemInStore(int itemId, seller*& itemSeller) {
+    MetricTimer timer(Metric::FIND_ITEM);
+    TRACE_SPAN("findItemInStore");
+    itemSeller = findSellerByItem(itemId);
+    Item* item = itemSeller ? itemSeller->findItemById(itemId) : nullptr;
+    if (!item) countEvent(Counter::ITEM_NOT_FOUND);
+    return item;
+}
+
+int addStoreItem(seller& store, const string& name, int quantity, double price) {
+    TRACE_SPAN("addStoreItem");
+    int id = ++itemIdCounter;
+    store.addNewItem(id, name, quantity, price);
+    store.makeItemVisibleToCustomer(id);
+    indexStoreItems(store, id, 1);
+    return id;
+}
+
+void indexStoreItems(seller& store, int firstId, int count) {
+    size_t end = static_cast<size_t>(firstId) + static_cast<size_t>(count);
+    if (itemOwners.size() < end) itemOwners.resize(max(end, itemOwners.size() * 2), nullptr);
+    fill_n(itemOwners.begin() + firstId, count, &store);
+}
+
+PaymentRequest paymentRequestFor(const Order& order, const Buyer& buyer) {
+    TRACE_SPAN("paymentRequestFor");
+    PaymentRequest request{order.getId(), buyer.getId(), buyer.getAccount().getId(), {}};
+    shared_lock<shared_mutex> lock(inventoryMutex);
+    for (const auto& item : order.getItems()) {
+        seller* store = findSeller(item.sellerId);
+        request.lines.push_back({item.sellerId,
+                                 store ? store->getAccount().getId() : 0,
+                                 store ? store->findItemById(item.itemId) : nullptr,
+                                 item.quantity,
+                                 item.price * item.quantity});
+    }
+    return request;
+}
+
+PaymentEngine& paymentEngine() {
+    // Created on first payment, so it shuts down before the ledger writer.
+    static PaymentEngine engine(myBank, transactionIdCounter, inventoryMutex);
+    return engine;
+}
@@ -0,0 +1,63 @@
+#ifndef STORE_H
+#define STORE_H
+
+#include <atomic>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+
+#include "append_log.h"
+#include "bank.h"
+#include "buyer.h"
+#include "item.h"
+#include "order.h"
+#include "payment_engine.h"
+#include "seller.h"
+
+// State shared by every session.
+
+extern Bank myBank;
+
+// Registered users. Entries never move, so a session may keep pointers to
+// them; appends are safe from any thread.
+extern AppendLog<Buyer> buyers;
+extern AppendLog<seller> sellers;
+
+// Guards every seller's item list and the items in it: hold it shared to
+// read stock or prices and exclusive to change them. Never hold it across
+// a co_await.
+extern std::shared_mutex inventoryMutex;
+
+extern std::atomic<int> buyerIdCounter;
+extern std::atomic<int> itemIdCounter;
+extern std::atomic<int> transactionIdCounter;
+extern std::atomic<int> orderIdCounter;
+
+// Opens a buyer under a fresh id for `account`, which has none yet.
+Buyer& addBuyer(const std::string& name, BankCustomer& account);
+Buyer* findBuyer(int id);
+Buyer* findBuyerByAccount(int accountId);
+// Through the bank's email index (Bank::findCustomerByEmail).
+Buyer* findBuyerByEmail(std::string_view email);
+seller* findSeller(int buyerId);
+// Opens a store for `owner`, or returns nullptr if they already run one.
+// Takes inventoryMutex itself, so racing sessions open at most one.
+seller* addSeller(Buyer& owner, const std::string& storeName);
+// Callers hold inventoryMutex.
+seller* findSellerByItem(int itemId);
+Item* findItemInStore(int itemId, seller*& itemSeller);
+
+// Adds a visible item to `store` under a fresh id and returns the id.
+// Callers hold inventoryMutex exclusively.
+int addStoreItem(seller& store, const std::string& name, int quantity, double price);
+// Records `store` as the owner of items firstId .. firstId + count - 1,
+// which it already holds. Callers hold inventoryMutex exclusively.
+void indexStoreItems(seller& store, int firstId, int count);
+
+// Resolves each line of `order` to its seller's bank account and stocked
+// item. Takes inventoryMutex itself.
+PaymentRequest paymentRequestFor(const Order& order, const Buyer& buyer);
+
+PaymentEngine& paymentEngine();
+
+#endif // STORE_H
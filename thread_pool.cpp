@@ -0,0 +1,49 @@
+#include "thread_pool.h"
+
+using namespace std;
+
+namespace {
+
+// The pool whose worker is running on this thread, if any.
+thread_local const ThreadPool* currentPool = nullptr;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t threadCount) : stopping(false) {
+    if (threadCount == 0) threadCount = 1;
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto& w : workers) w.join();
+}
+
+bool ThreadPool::isWorkerThread() const { return currentPool == this; }
+
+void ThreadPool::workerLoop() {
+    currentPool = this;
+    while (true) {
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            wakeUp.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+        task();
+    }
+}
+
+ThreadPool& analyticsPool() {
+    static ThreadPool pool(thread::hardware_concurrency());
+    return pool;
+}
@@ -0,0 +1,132 @@
+#ifndef TOP_K_H
+#define TOP_K_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Counts weights per key in an open-addressing (linear probing) table and
+// selects the K heaviest keys without sorting the whole key set.
+// Ranking matches the old "sort pairs descending" reports: higher weight
+// first, ties broken by the larger key.
+template <typename Key, typename Weight = int, typename Hash = std::hash<Key>>
+class TopKAggregator {
+private:
+    struct Slot {
+        Key key{};
+        Weight weight{};
+        bool used = false;
+    };
+
+    std::vector<Slot> slots;
+    std::size_t count;
+    unsigned shift;
+
+    std::size_t slotFor(const Key& key) const {
+        // Fibonacci hashing spreads sequential ids across the table.
+        std::uint64_t h = static_cast<std::uint64_t>(Hash{}(key)) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<std::size_t>(h >> shift);
+    }
+
+    void rehash(std::size_t newCapacity) {
+        std::vector<Slot> old = std::move(slots);
+        slots.assign(newCapacity, Slot{});
+        shift = 64;
+        for (std::size_t c = newCapacity; c > 1; c >>= 1) shift--;
+        count = 0;
+        for (auto& s : old) {
+            if (s.used) add(s.key, s.weight);
+        }
+    }
+
+public:
+    explicit TopKAggregator(std::size_t expectedKeys = 16) : count(0), shift(64) {
+        std::size_t capacity = 16;
+        while (capacity * 7 < expectedKeys * 10) capacity <<= 1;
+        rehash(capacity);
+    }
+
+    void add(const Key& key, Weight weight = 1) {
+        if ((count + 1) * 10 > slots.size() * 7) rehash(slots.size() * 2);
+        std::size_t mask = slots.size() - 1;
+        for (std::size_t i = slotFor(key);; i = (i + 1) & mask) {
+            Slot& s = slots[i];
+            if (!s.used) {
+                s.key = key;
+                s.weight = weight;
+                s.used = true;
+                count++;
+                return;
+            }
+            if (s.key == key) {
+                s.weight += weight;
+                return;
+            }
+        }
+    }
+
+    // Folds every record accepted by `keep` into the table under `key(record)`.
+    template <typename Range, typename KeyFn, typename FilterFn, typename WeightFn>
+    void scan(const Range& records, KeyFn key, FilterFn keep, WeightFn weight) {
+        for (const auto& r : records) {
+            if (keep(r)) add(key(r), weight(r));
+        }
+    }
+
+    void merge(const TopKAggregator& other) {
+        for (const auto& s : other.slots) {
+            if (s.used) add(s.key, s.weight);
+        }
+    }
+
+    Weight weightOf(const Key& key) const {
+        std::size_t mask = slots.size() - 1;
+        for (std::size_t i = slotFor(key); slots[i].used; i = (i + 1) & mask) {
+            if (slots[i].key == key) return slots[i].weight;
+        }
+        return Weight{};
+    }
+
+    bool contains(const Key& key) const { return weightOf(key) != Weight{}; }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // Returns up to k (weight, key) pairs, heaviest first.
+    std::vector<std::pair<Weight, Key>> top(std::size_t k) const {
+        std::vector<std::pair<Weight, Key>> entries;
+        entries.reserve(count);
+        for (const auto& s : slots) {
+            if (s.used) entries.emplace_back(s.weight, s.key);
+        }
+        k = std::min(k, entries.size());
+        std::partial_sort(entries.begin(), entries.begin() + static_cast<std::ptrdiff_t>(k), entries.end(),
+                          std::greater<std::pair<Weight, Key>>());
+        entries.resize(k);
+        return entries;
+    }
+};
+
+struct KeepAll {
+    template <typename T>
+    bool operator()(const T&) const { return true; }
+};
+
+struct UnitWeight {
+    template <typename T>
+    int operator()(const T&) const { return 1; }
+};
+
+// One-shot form of TopKAggregator for reports that rank a single range.
+template <typename Key, typename Range, typename KeyFn, typename FilterFn = KeepAll, typename WeightFn = UnitWeight>
+auto topK(const Range& records, std::size_t k, KeyFn key, FilterFn keep = FilterFn(), WeightFn weight = WeightFn()) {
+    using Weight = decltype(weight(*std::begin(records)));
+    TopKAggregator<Key, Weight> agg;
+    agg.scan(records, key, keep, weight);
+    return agg.top(k);
+}
+
+#endif // TOP_K_H
@@ -0,0 +1,162 @@
+#include "trace.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    int64_t start;   // traceNow() values
+    int64_t end;
+};
+
+// One thread's spans. The owner appends under `lock`, which only the
+// writer of the trace file ever contends for.
+struct TraceRing {
+    static constexpr size_t kCapacity = 16384;
+
+    mutex lock;
+    vector<TraceEvent> events;
+    size_t next = 0;
+    int tid;
+
+    explicit TraceRing(int tid) : tid(tid) { events.reserve(kCapacity); }
+
+    void push(const TraceEvent& e) {
+        lock_guard<mutex> guard(lock);
+        if (events.size() < kCapacity) {
+            events.push_back(e);
+        } else {
+            events[next] = e;
+            next = (next + 1) % kCapacity;
+        }
+    }
+
+    // Oldest first, then empties the ring.
+    vector<TraceEvent> drain() {
+        lock_guard<mutex> guard(lock);
+        vector<TraceEvent> out;
+        out.reserve(events.size());
+        out.insert(out.end(), events.begin() + static_cast<ptrdiff_t>(next), events.end());
+        out.insert(out.end(), events.begin(), events.begin() + static_cast<ptrdiff_t>(next));
+        events.clear();
+        next = 0;
+        return out;
+    }
+};
+
+// Rings are kept after their thread exits so its spans can still be
+// written, and handed to the next thread that needs one.
+struct Registry {
+    mutex lock;
+    vector<unique_ptr<TraceRing>> all;
+    vector<TraceRing*> idle;
+};
+
+Registry& registry() {
+    // Never destroyed: the exit-time writer and late threads still use it.
+    static Registry* instance = new Registry;
+    return *instance;
+}
+
+struct Lease {
+    TraceRing* ring = nullptr;
+
+    ~Lease() {
+        if (!ring) return;
+        Registry& r = registry();
+        lock_guard<mutex> guard(r.lock);
+        r.idle.push_back(ring);
+    }
+};
+
+thread_local Lease lease;
+
+TraceRing& threadRing() {
+    if (lease.ring) return *lease.ring;
+    Registry& r = registry();
+    lock_guard<mutex> guard(r.lock);
+    if (r.idle.empty()) {
+        r.all.push_back(make_unique<TraceRing>(static_cast<int>(r.all.size()) + 1));
+        lease.ring = r.all.back().get();
+    } else {
+        lease.ring = r.idle.back();
+        r.idle.pop_back();
+    }
+    return *lease.ring;
+}
+
+struct ExitWriter {
+    string path;
+    ~ExitWriter() {
+        if (!path.empty()) writeChromeTraceFile(path);
+    }
+};
+
+ExitWriter exitWriter;
+
+} // namespace
+
+atomic<unsigned> traceSampleEvery{0};
+
+void setTraceSampling(unsigned everyN) { traceSampleEvery.store(everyN, memory_order_relaxed); }
+
+unsigned traceSampling() { return traceSampleEvery.load(memory_order_relaxed); }
+
+int64_t traceNow() {
+    static const chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count();
+}
+
+void recordSpan(const char* name, int64_t start, int64_t end) { threadRing().push({name, start, end}); }
+
+size_t writeChromeTrace(ostream& out) {
+    vector<TraceRing*> rings;
+    {
+        Registry& r = registry();
+        lock_guard<mutex> guard(r.lock);
+        for (auto& ring : r.all) rings.push_back(ring.get());
+    }
+
+    size_t written = 0;
+    bool first = true;
+    auto separator = [&]() -> ostream& {
+        if (!first) out << ",\n";
+        first = false;
+        return out;
+    };
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    out << fixed << setprecision(3);
+    for (TraceRing* ring : rings) {
+        vector<TraceEvent> events = ring->drain();
+        if (events.empty()) continue;
+        separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->tid
+                    << ",\"args\":{\"name\":\"thread " << ring->tid << "\"}}";
+        // Chrome timestamps are microseconds.
+        for (const TraceEvent& e : events) {
+            separator() << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->tid
+                        << ",\"ts\":" << static_cast<double>(e.start) / 1000.0
+                        << ",\"dur\":" << static_cast<double>(e.end - e.start) / 1000.0 << "}";
+        }
+        written += events.size();
+    }
+    out << "\n]}\n";
+    return written;
+}
+
+bool writeChromeTraceFile(const string& path) {
+    ofstream file(path, ios::trunc);
+    if (!file) return false;
+    writeChromeTrace(file);
+    return static_cast<bool>(file);
+}
+
+void writeTraceAtExit(const string& path) { exitWriter.path = path; }
@@ -0,0 +1,93 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Scoped trace spans, written out as Chrome trace-event JSON (open the
+// file in chrome://tracing or ui.perfetto.dev).
+//
+//   TRACE_SPAN("Bank::withdraw");   // times the rest of the scope
+//
+// Spans are recorded per thread into a fixed ring buffer; when it is full
+// the oldest spans are overwritten. Sampling is decided at the outermost
+// span of each thread: with setTraceSampling(n) one root span in n is
+// recorded together with everything nested inside it, and n = 0 (the
+// default) records nothing. An unsampled span costs a counter update.
+// Spans nest by thread, so never keep one open across a co_await.
+//
+// Building with -DENABLE_TRACING=0 (meson -Dtracing=false) compiles every
+// TRACE_SPAN out; the functions below remain and produce an empty trace.
+#ifndef ENABLE_TRACING
+#define ENABLE_TRACING 1
+#endif
+
+void setTraceSampling(unsigned everyN);
+unsigned traceSampling();
+
+// Writes every buffered span and empties the buffers. Returns the number
+// of spans written.
+std::size_t writeChromeTrace(std::ostream& out);
+bool writeChromeTraceFile(const std::string& path);
+// Writes the trace to `path` when the program exits.
+void writeTraceAtExit(const std::string& path);
+
+extern std::atomic<unsigned> traceSampleEvery;
+
+// Nanoseconds since the first call.
+std::int64_t traceNow();
+void recordSpan(const char* name, std::int64_t start, std::int64_t end);
+
+#if ENABLE_TRACING
+
+struct TraceThreadState {
+    unsigned depth = 0;
+    bool sampled = false;
+    std::uint64_t roots = 0;
+};
+
+inline thread_local TraceThreadState traceThreadState;
+
+// `name` must outlive the program: a literal or a static table entry.
+class TraceSpan {
+private:
+    const char* name;
+    std::int64_t started = 0;
+    bool active = false;
+
+public:
+    explicit TraceSpan(const char* name) : name(name) {
+        TraceThreadState& t = traceThreadState;
+        if (t.depth++ == 0) {
+            unsigned every = traceSampleEvery.load(std::memory_order_relaxed);
+            t.sampled = every != 0 && t.roots++ % every == 0;
+        }
+        if (t.sampled) {
+            active = true;
+            started = traceNow();
+        }
+    }
+
+    ~TraceSpan() {
+        if (active) recordSpan(name, started, traceNow());
+        --traceThreadState.depth;
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+
+#else
+
+#define TRACE_SPAN(name) static_cast<void>(0)
+
+#endif // ENABLE_TRACING
+
+#endif // TRACE_H
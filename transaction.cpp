@@ -1,13 +1,13 @@
 #include "transaction.h"
 #include <iostream>
-#include <ctime>
-#include <iomanip>
+#include <string_view>
+
+#include "report_writer.h"
 
 using namespace std;
 
-void Transaction::printTimestamp() const {
-    time_t tt = chrono::system_clock::to_time_t(timestamp);
-    struct tm * ptm = localtime(&tt);
-    
-    cout << "Date/Time: " << put_time(ptm, "%Y-%m-%d %H:%M:%S") << endl;
+void Transaction::printTimestamp(ostream& out) const {
+    char stamp[kTimestampLength];
+    formatTimestamp(timestamp, stamp);
+    out << "Date/Time: " << string_view(stamp, sizeof(stamp)) << "\n";
 }
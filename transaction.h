@@ -3,6 +3,9 @@
 
 #include <string>
 #include <chrono>
+#include <iostream>
+
+#include "clock.h"
 
 using namespace std;
 
@@ -21,18 +24,24 @@ private:
 public:
     Transaction(int id, int buyerId, int sellerId, const string& itemName, double amount) 
         : id(id), buyerId(buyerId), sellerId(sellerId), itemName(itemName), amount(amount) {
-        timestamp = chrono::system_clock::now(); 
+        timestamp = clockNow(); 
         status = PAID; 
     }
 
+    // For transactions that happened earlier, e.g. generated history.
+    Transaction(int id, int buyerId, int sellerId, const string& itemName, double amount,
+                chrono::system_clock::time_point timestamp)
+        : id(id), buyerId(buyerId), sellerId(sellerId), itemName(itemName), amount(amount),
+          timestamp(timestamp), status(PAID) {}
+
     int getId() const { return id; }
     int getBuyerId() const { return buyerId; }
     int getSellerId() const { return sellerId; }
-    string getItemName() const { return itemName; }
+    const string& getItemName() const { return itemName; }
     double getAmount() const { return amount; }
     chrono::system_clock::time_point getTimestamp() const { return timestamp; }
     Status getStatus() const { return status; }
-    string getStatusString() const {
+    const char* getStatusString() const {
         switch (status) {
             case PAID: return "PAID";
             case CANCELED: return "CANCELED";
@@ -44,7 +53,7 @@ public:
     void markAsCanceled() { status = CANCELED; }
     void markAsCompleted() { status = COMPLETED; }
     
-    void printTimestamp() const;
+    void printTimestamp(ostream& out = cout) const;
 };
 
 #endif // TRANSACTION_H
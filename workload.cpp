@@ -0,0 +1,248 @@
+#include "workload.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "clock.h"
+#include "ledger.h"
+#include "store.h"
+
+using namespace std;
+
+namespace {
+
+// splitmix64. A fixed algorithm rather than <random>'s distributions, whose
+// output differs between standard libraries, so a seed means one history.
+class Random {
+private:
+    uint64_t state;
+
+public:
+    explicit Random(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, 1).
+    double uniform() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+    // Uniform in [lo, hi].
+    int between(int lo, int hi) { return lo + static_cast<int>(next() % static_cast<uint64_t>(hi - lo + 1)); }
+
+    double cents(int loCents, int hiCents) { return between(loCents, hiCents) / 100.0; }
+};
+
+// Draws 0..n-1 with P(k) proportional to 1 / rank(k)^s. Ranks are a
+// random permutation, so popularity is not tied to creation order.
+class ZipfSampler {
+private:
+    vector<double> cumulative;
+    vector<size_t> byRank;
+
+public:
+    ZipfSampler(size_t n, double s, Random& random) : cumulative(n), byRank(n) {
+        double total = 0;
+        for (size_t r = 0; r < n; ++r) {
+            total += 1.0 / pow(static_cast<double>(r + 1), s);
+            cumulative[r] = total;
+            byRank[r] = r;
+        }
+        for (size_t i = n; i > 1; --i) swap(byRank[i - 1], byRank[random.next() % i]);
+    }
+
+    size_t sample(Random& random) const {
+        double target = random.uniform() * cumulative.back();
+        size_t rank = static_cast<size_t>(upper_bound(cumulative.begin(), cumulative.end(), target) - cumulative.begin());
+        return byRank[min(rank, byRank.size() - 1)];
+    }
+};
+
+struct Stocked {
+    seller* store;
+    Item* item;
+};
+
+template <typename T>
+bool parseField(string_view text, T& value) {
+    auto [ptr, ec] = from_chars(text.data(), text.data() + text.size(), value);
+    return !text.empty() && ec == errc() && ptr == text.data() + text.size();
+}
+
+} // namespace
+
+WorkloadSummary generateWorkload(const WorkloadOptions& options) {
+    auto started = chrono::steady_clock::now();
+    WorkloadSummary summary;
+    if (options.accounts <= 0) return summary;
+
+    Random random(options.seed);
+    auto now = clockNow();
+    auto span = chrono::duration_cast<chrono::system_clock::duration>(chrono::hours(24) * max(options.days, 1));
+    auto begin = now - span;
+    auto at = [&](double fraction) {
+        return begin + chrono::duration_cast<chrono::system_clock::duration>(span * fraction);
+    };
+
+    // Accounts open during the first day of the window.
+    double firstDay = 1.0 / max(options.days, 1);
+    vector<Buyer*> shoppers;
+    shoppers.reserve(static_cast<size_t>(options.accounts));
+    for (int i = 1; i <= options.accounts; ++i) {
+        // Numbered by account id, so repeated runs never reuse an email or
+        // phone (Bank::createAccount rejects duplicates).
+        int accountId = myBank.getNextCustomerId();
+        string number = to_string(accountId);
+        string name = "user" + number;
+        BankCustomer& account = myBank.createAccount(name, random.cents(20000, 500000), "Jl. Sintetis " + number,
+                                                     "08" + to_string(100000000 + accountId), name + "@example.com",
+                                                     at(random.uniform() * firstDay));
+        shoppers.push_back(&addBuyer(name, account));
+    }
+    summary.accounts = options.accounts;
+
+    vector<Stocked> catalog;
+    int storeCount = min(max(options.sellers, 0), options.accounts);
+    int perStore = max(options.itemsPerSeller, 0);
+    for (int i = 0; i < storeCount; ++i) {
+        Buyer& owner = *shoppers[static_cast<size_t>(i)];
+        seller& store = sellers.emplace_back(owner, owner.getId(), "Store " + to_string(i + 1));
+        if (perStore == 0) continue;
+
+        vector<Item> batch;
+        batch.reserve(static_cast<size_t>(perStore));
+        int first = itemIdCounter.fetch_add(perStore) + 1;
+        for (int k = 0; k < perStore; ++k) {
+            Item& item = batch.emplace_back(first + k, "Item " + to_string(first + k), random.between(500, 5000),
+                                            random.cents(100, 50000));
+            item.setDisplay(true);
+        }
+        unique_lock<shared_mutex> lock(inventoryMutex);
+        store.addItems(batch);
+        indexStoreItems(store, first, perStore);
+        for (int k = 0; k < perStore; ++k) catalog.push_back({&store, store.findItemById(first + k)});
+    }
+    summary.sellers = storeCount;
+    summary.items = static_cast<int>(catalog.size());
+
+    ZipfSampler pickBuyer(shoppers.size(), options.zipf, random);
+    ZipfSampler pickItem(max<size_t>(catalog.size(), 1), options.zipf, random);
+
+    for (size_t e = 0; e < options.events; ++e) {
+        auto when = at(firstDay + (1.0 - firstDay) * (static_cast<double>(e) + random.uniform()) /
+                                      static_cast<double>(options.events));
+        Buyer& buyer = *shoppers[pickBuyer.sample(random)];
+        BankCustomer& account = buyer.getAccount();
+        double roll = random.uniform();
+
+        if (roll >= 0.67 || catalog.empty()) {
+            if (roll < 0.87) {
+                double amount = random.cents(1000, 50000);
+                account.addBalance(amount);
+                recordCashFlow(CashFlowLog(account.getId(), "Credit", amount, "User Topup/Deposit", when));
+                ++summary.deposits;
+            } else {
+                double amount = random.cents(1000, 30000);
+                if (account.withdrawBalance(amount)) {
+                    recordCashFlow(CashFlowLog(account.getId(), "Debit", amount, "User Withdrawal", when));
+                    ++summary.withdrawals;
+                } else {
+                    ++summary.declined;
+                }
+            }
+            continue;
+        }
+
+        // A checkout of one to four lines; 5 in 67 are left unpaid.
+        Order order(++orderIdCounter, buyer.getId());
+        vector<pair<Stocked, int>> lines;
+        for (int n = random.between(1, 4); n > 0; --n) {
+            Stocked line = catalog[pickItem.sample(random)];
+            int quantity = random.between(1, 3);
+            bool repeated = any_of(lines.begin(), lines.end(), [&](const auto& l) { return l.first.item == line.item; });
+            if (repeated || line.item->getQuantity() < quantity) continue;
+            order.addItem(line.item->getId(), line.item->getName(), line.item->getPrice(), quantity, line.store->getId());
+            lines.push_back({line, quantity});
+        }
+        if (lines.empty()) continue;
+
+        if (roll >= 0.62) {
+            ++summary.unpaidOrders;
+            buyer.addOrder(std::move(order));
+            continue;
+        }
+        // Buyers who cannot cover a checkout top up first, as real ones do.
+        double shortfall = order.getTotalAmount() - account.getBalance();
+        if (shortfall > 0) {
+            double amount = ceil(shortfall) + random.cents(1000, 50000);
+            account.addBalance(amount);
+            recordCashFlow(CashFlowLog(account.getId(), "Credit", amount, "User Topup/Deposit", when));
+            ++summary.deposits;
+        }
+        if (account.withdrawBalance(order.getTotalAmount())) {
+            string tag = invoiceTag(order.getId());
+            // Keyed by seller id so the ledger order is the same every run.
+            map<int, pair<seller*, double>> credits;
+            for (const auto& [line, quantity] : lines) {
+                line.item->discard(quantity);
+                auto& credit = credits.try_emplace(line.store->getId(), line.store, 0.0).first->second;
+                credit.second += line.item->getPrice() * quantity;
+            }
+            vector<CashFlowLog> flows;
+            flows.emplace_back(account.getId(), "Debit", order.getTotalAmount(), tag + " Payment", when);
+            for (const auto& [id, credit] : credits) {
+                credit.first->getAccount().addBalance(credit.second);
+                flows.emplace_back(credit.first->getAccount().getId(), "Credit", credit.second, tag + " Sale", when);
+            }
+            recordCashFlows(std::move(flows));
+            string name = tag + " (" + to_string(lines.size()) + " items)";
+            for (const auto& [id, credit] : credits) {
+                recordTransaction(Transaction(++transactionIdCounter, buyer.getId(), id, name, credit.second, when));
+            }
+            order.markAsPaid();
+            ++summary.paidOrders;
+        } else {
+            ++summary.declined;
+            ++summary.unpaidOrders;
+        }
+        buyer.addOrder(std::move(order));
+    }
+
+    syncLedger();
+    summary.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    return summary;
+}
+
+bool parseWorkloadSpec(string_view spec, WorkloadOptions& options) {
+    while (!spec.empty()) {
+        size_t comma = spec.find(',');
+        string_view field = spec.substr(0, comma);
+        spec = comma == string_view::npos ? string_view{} : spec.substr(comma + 1);
+
+        size_t eq = field.find('=');
+        if (eq == string_view::npos) return false;
+        string_view key = field.substr(0, eq), value = field.substr(eq + 1);
+        bool ok;
+        if (key == "seed") ok = parseField(value, options.seed);
+        else if (key == "accounts") ok = parseField(value, options.accounts) && options.accounts > 0;
+        else if (key == "sellers") ok = parseField(value, options.sellers) && options.sellers >= 0;
+        else if (key == "itemsPerSeller") ok = parseField(value, options.itemsPerSeller) && options.itemsPerSeller >= 0;
+        else if (key == "events") ok = parseField(value, options.events);
+        else if (key == "days") ok = parseField(value, options.days) && options.days > 0;
+        else if (key == "zipf") ok = parseField(value, options.zipf) && options.zipf >= 0;
+        else ok = false;
+        if (!ok) return false;
+    }
+    return true;
+}
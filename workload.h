@@ -0,0 +1,51 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Synthetic store history for scale testing.
+//
+// generateWorkload() opens `accounts` bank accounts through
+// Bank::createAccount, each with a buyer. It upgrades the first `sellers`
+// of them to stores stocking `itemsPerSeller` items each. It then plays
+// `events` shopping events spread over the last `days` days: checkouts
+// (paid, or left as unpaid invoices), deposits and withdrawals. Buyers and
+// items are drawn from Zipf distributions with exponent `zipf`, so a few
+// are very popular and most are rarely touched, as in production.
+//
+// Everything is written straight into the store, the bank and the ledger
+// with back-dated timestamps, so the 30-day windows and "today" reports
+// have realistic data. The same options and seed always produce the same
+// history. Run it before serving any session.
+struct WorkloadOptions {
+    std::uint64_t seed = 1;
+    int accounts = 1000;
+    int sellers = 50;
+    int itemsPerSeller = 100;
+    std::size_t events = 100000;
+    int days = 90;
+    double zipf = 1.1;
+};
+
+struct WorkloadSummary {
+    int accounts = 0;
+    int sellers = 0;
+    int items = 0;
+    std::size_t paidOrders = 0;
+    std::size_t unpaidOrders = 0;
+    std::size_t deposits = 0;
+    std::size_t withdrawals = 0;
+    std::size_t declined = 0;    // payments or withdrawals the balance did not cover
+    double seconds = 0;
+};
+
+WorkloadSummary generateWorkload(const WorkloadOptions& options);
+
+// Parses "key=value,key=value" using the field names above, for example
+// "accounts=100000,sellers=500,itemsPerSeller=200,events=5000000,seed=7".
+// Unnamed fields keep their defaults.
+bool parseWorkloadSpec(std::string_view spec, WorkloadOptions& options);
+
+#endif // WORKLOAD_H